@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <alloc_counter.h>
+
+// Minimal benchmark harness: BENCH("group") { ...setup...; state.run("variant", [&]{ ...operation... }); }
+// Each run() is calibrated to take about min_time seconds and reports ns/op, bytes/s (if state.bytes is set) and
+// heap allocations per operation.
+namespace bench {
+
+// prevents compiler from optimizing away value computation
+template <class T>
+inline void keep (const T& value) { asm volatile("" : : "r"(&value) : "memory"); }
+
+struct Result {
+    std::string name;
+    uint64_t    iterations;
+    double      ns_per_op;
+    double      bytes_per_sec; // 0 if not applicable
+    double      allocs_per_op;
+    double      alloc_bytes_per_op;
+};
+
+struct Config {
+    double      min_time    = 0.2;
+    int         repetitions = 3;
+    std::string filter;
+};
+
+struct State {
+    size_t bytes = 0; // bytes processed by one operation, for throughput
+
+    State (const std::string& group, const Config& config, std::vector<Result>& results) : _group(group), _config(config), _results(results) {}
+
+    template <class F>
+    void run (const std::string& variant, F&& op) {
+        using clock = std::chrono::steady_clock;
+        auto name = variant.empty() ? _group : _group + "/" + variant;
+        if (name.find(_config.filter) == std::string::npos) return;
+
+        auto measure = [&](uint64_t n) {
+            auto start = clock::now();
+            for (uint64_t i = 0; i < n; ++i) op();
+            return std::chrono::duration<double>(clock::now() - start).count();
+        };
+
+        op(); // warm up lazy initialization and caches
+        uint64_t n = 1;
+        double elapsed;
+        while ((elapsed = measure(n)) < _config.min_time / 10 && n < (uint64_t(1) << 40)) n *= 2;
+        n = std::max<uint64_t>(1, n * (_config.min_time / std::max(elapsed, 1e-9)));
+
+        auto before = alloc_counter::current();
+        double best = measure(n);
+        auto after  = alloc_counter::current();
+        for (int i = 1; i < _config.repetitions; ++i) best = std::min(best, measure(n));
+
+        _results.push_back({
+            name, n, best * 1e9 / n, bytes ? bytes * n / best : 0,
+            double(after.allocs - before.allocs) / n, double(after.bytes - before.bytes) / n
+        });
+    }
+
+    template <class F>
+    void run (F&& op) { run("", std::forward<F>(op)); }
+
+private:
+    std::string          _group;
+    const Config&        _config;
+    std::vector<Result>& _results;
+};
+
+using Func = void(*)(State&);
+
+struct Registrar {
+    Registrar (const char* group, Func);
+};
+
+}
+
+#define BENCH_CAT_(a, b) a##b
+#define BENCH_CAT(a, b)  BENCH_CAT_(a, b)
+#define BENCH_IMPL_(group, fn)                                     \
+    static void fn (bench::State&);                                \
+    static bench::Registrar BENCH_CAT(fn, _registrar)(group, fn);  \
+    static void fn (bench::State& state)
+#define BENCH(group) BENCH_IMPL_(group, BENCH_CAT(_bench_, __LINE__))
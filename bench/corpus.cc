@@ -0,0 +1,274 @@
+#include "bench.h"
+#include <map>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <panda/uri/all.h>
+
+// Corpus replay: newline-delimited URIs are run through parse, query access, mutation and serialization stages,
+// each stage is timed separately over the whole corpus. Generator produces reproducible synthetic corpora.
+
+using namespace panda;
+using namespace panda::uri;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+    struct Stage {
+        const char* name;
+        double      seconds = 0;
+        uint64_t    bytes   = 0;
+        uint64_t    uris    = 0;
+        uint64_t    allocs  = 0;
+    };
+
+    struct Mapping {
+        const char* data = nullptr;
+        size_t      size = 0;
+
+        ~Mapping () { if (data) munmap((void*)data, size); }
+    };
+}
+
+static bool map_file (const char* path, Mapping& m) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = p != MAP_FAILED;
+        if (ok) {
+            m.data = (const char*)p;
+            m.size = st.st_size;
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+template <class F>
+static void timed (Stage& stage, size_t passes, F&& f) {
+    for (size_t pass = 0; pass < passes; ++pass) {
+        auto allocs = alloc_counter::current().allocs;
+        auto start  = clock_type::now();
+        f(stage);
+        stage.seconds += std::chrono::duration<double>(clock_type::now() - start).count();
+        stage.allocs  += alloc_counter::current().allocs - allocs;
+    }
+}
+
+int corpus_main (int argc, char** argv) {
+    const char* path = nullptr;
+    std::string format = "text";
+    size_t passes = 3;
+    int flags = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if      (!strncmp(arg, "--format=", 9)) format = arg + 9;
+        else if (!strncmp(arg, "--passes=", 9)) passes = std::max(1, atoi(arg + 9));
+        else if (!strcmp(arg, "--ext"))         flags |= URI::Flags::allow_extended_chars;
+        else if (arg[0] != '-')                 path = arg;
+        else { fprintf(stderr, "unknown option %s\n", arg); return 1; }
+    }
+    if (!path || (format != "text" && format != "json")) {
+        fprintf(stderr, "usage: panda-uri-bench corpus [--format=text|json] [--passes=N] [--ext] FILE\n");
+        return 1;
+    }
+
+    Mapping corpus;
+    if (!map_file(path, corpus)) { perror(path); return 1; }
+
+    // lines are copied into strings once, like a server receives them, this is not timed
+    std::vector<string> lines;
+    uint64_t total_bytes = 0;
+    for (const char *p = corpus.data, *end = p + corpus.size; p < end;) {
+        auto nl = (const char*)memchr(p, '\n', end - p);
+        auto le = nl ? nl : end;
+        size_t len = le - p;
+        if (len && p[len-1] == '\r') --len;
+        if (len) {
+            lines.push_back(string(p, len));
+            total_bytes += len;
+        }
+        p = le + 1;
+    }
+
+    std::vector<URI> uris(lines.size());
+    Stage parse{"parse"}, query{"query"}, mutate{"mutate"}, serialize{"serialize"};
+    size_t failed = 0;
+
+    timed(parse, passes, [&](Stage& st) {
+        for (size_t i = 0; i < lines.size(); ++i) uris[i] = URI(lines[i], flags);
+        st.bytes += total_bytes;
+        st.uris  += lines.size();
+    });
+    for (auto& uri : uris) failed += !uri.host() && !uri.path();
+
+    timed(query, passes, [&](Stage& st) {
+        for (auto& uri : uris) {
+            auto qstr = uri.query_string();
+            uri.query_string(qstr); // drop parsed query so that every pass parses it
+            bench::keep(uri.param("utm_source"));
+            st.bytes += qstr.length();
+        }
+        st.uris += uris.size();
+    });
+
+    std::vector<URI> work;
+    timed(mutate, passes, [&](Stage& st) {
+        work = uris; // copying is what COW mutation of shared URI costs too
+        for (auto& uri : work) {
+            uri.param("session", "0123456789abcdef");
+            uri.fragment("");
+            if (uri.port() == 80) uri.port(8080);
+        }
+        st.uris += work.size();
+    });
+
+    timed(serialize, passes, [&](Stage& st) {
+        for (auto& uri : work) {
+            uri.path(uri.path()); // drop cached string so that every pass serializes
+            auto str = uri.to_string();
+            st.bytes += str.length();
+        }
+        st.uris += work.size();
+    });
+
+    Stage* stages[] = {&parse, &query, &mutate, &serialize};
+    if (format == "json") {
+        printf("{\n  \"corpus\": \"%s\",\n  \"uris\": %zu,\n  \"bytes\": %llu,\n  \"failed\": %zu,\n  \"passes\": %zu,\n  \"stages\": [\n",
+               path, lines.size(), (unsigned long long)total_bytes, failed, passes);
+        for (size_t i = 0; i < 4; ++i) {
+            auto& s = *stages[i];
+            printf("    {\"name\": \"%s\", \"seconds\": %.6f, \"mb_per_sec\": %.3f, \"uris_per_sec\": %.0f, \"allocs_per_uri\": %.3f}%s\n",
+                   s.name, s.seconds, s.bytes / s.seconds / 1e6, s.uris / s.seconds, s.uris ? double(s.allocs) / s.uris : 0.0, i < 3 ? "," : "");
+        }
+        printf("  ]\n}\n");
+    } else {
+        printf("corpus %s: %zu URIs, %llu bytes, %zu failed to parse, %zu passes\n", path, lines.size(), (unsigned long long)total_bytes, failed, passes);
+        printf("%-12s %12s %12s %14s %14s\n", "stage", "seconds", "MB/s", "URIs/s", "allocs/URI");
+        for (auto st : stages) {
+            auto& s = *st;
+            printf("%-12s %12.4f ", s.name, s.seconds);
+            if (s.bytes) printf("%12.1f ", s.bytes / s.seconds / 1e6);
+            else         printf("%12s ", "-");
+            printf("%14.0f %14.2f\n", s.uris / s.seconds, s.uris ? double(s.allocs) / s.uris : 0.0);
+        }
+    }
+    return 0;
+}
+
+// ===================== generator =====================
+
+namespace {
+    struct Generator {
+        std::mt19937_64 rnd;
+
+        Generator (uint64_t seed) : rnd(seed) {}
+
+        size_t      num  (size_t from, size_t to) { return std::uniform_int_distribution<size_t>(from, to)(rnd); }
+        std::string word (size_t from, size_t to) {
+            std::string ret(num(from, to), ' ');
+            for (auto& c : ret) c = "abcdefghijklmnopqrstuvwxyz0123456789"[num(0, 35)];
+            return ret;
+        }
+        std::string pct (size_t nbytes) {
+            std::string ret;
+            char buf[4];
+            for (size_t i = 0; i < nbytes; ++i) {
+                snprintf(buf, sizeof(buf), "%%%02X", unsigned(num(0x80, 0xFF)));
+                ret += buf;
+            }
+            return ret;
+        }
+        std::string host () { return word(3, 12) + "." + (num(0, 1) ? "com" : "example.org"); }
+        std::string path (size_t segments) {
+            std::string ret;
+            for (size_t i = 0; i < segments; ++i) ret += "/" + word(2, 10);
+            return ret;
+        }
+
+        std::string simple   () { return "http://" + host() + path(num(0, 2)); }
+        std::string typical  () { return "https://www." + host() + path(num(1, 4)) + "?" + word(1, 6) + "=" + word(1, 10) + "&page=" + std::to_string(num(1, 99)) + "#" + word(3, 8); }
+        std::string ipv6     () {
+            char addr[40];
+            snprintf(addr, sizeof(addr), "2001:db8:%x::%x", unsigned(num(0, 0xffff)), unsigned(num(1, 0xffff)));
+            return std::string("http://[") + addr + "]:" + std::to_string(num(1024, 65535)) + path(num(1, 3));
+        }
+        std::string userinfo () { return "ftp://" + word(3, 8) + ":" + word(6, 12) + "@" + host() + ":21" + path(num(1, 3)); }
+        std::string percent  () { return "https://" + host() + "/" + pct(num(4, 12)) + "/" + pct(num(2, 8)) + "?q=" + pct(num(2, 10)) + "%20" + word(1, 5); }
+        std::string lenient  () { return "http://" + host() + "/search?param={\"" + word(1, 5) + "\",\"" + word(1, 5) + "|" + word(1, 5) + "\"}&q=" + word(1, 5) + "|" + word(1, 5); }
+        std::string tracking () {
+            std::string ret = "https://ads." + host() + "/click?utm_source=" + word(3, 10) + "&utm_medium=cpc&utm_campaign=" + word(5, 20);
+            for (size_t i = 0, n = num(8, 40); i < n; ++i) ret += "&" + word(2, 8) + "=" + word(4, 30);
+            return ret;
+        }
+    };
+
+    using ShapeFn = std::string (Generator::*)();
+}
+
+int generate_main (int argc, char** argv) {
+    static const std::map<std::string, ShapeFn> shapes = {
+        {"simple",   &Generator::simple},
+        {"typical",  &Generator::typical},
+        {"ipv6",     &Generator::ipv6},
+        {"userinfo", &Generator::userinfo},
+        {"percent",  &Generator::percent},
+        {"lenient",  &Generator::lenient},
+        {"tracking", &Generator::tracking},
+    };
+
+    size_t count = 100000;
+    uint64_t seed = 1;
+    std::string mix = "simple=2,typical=4,ipv6=1,userinfo=1,percent=1,tracking=2";
+    const char* outfile = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if      (!strncmp(arg, "--count=", 8)) count   = strtoull(arg + 8, nullptr, 10);
+        else if (!strncmp(arg, "--seed=", 7))  seed    = strtoull(arg + 7, nullptr, 10);
+        else if (!strncmp(arg, "--mix=", 6))   mix     = arg + 6;
+        else if (!strncmp(arg, "--out=", 6))   outfile = arg + 6;
+        else {
+            fprintf(stderr, "usage: panda-uri-bench generate [--count=N] [--seed=N] [--mix=SHAPE=WEIGHT,...] [--out=FILE]\nshapes:");
+            for (auto& row : shapes) fprintf(stderr, " %s", row.first.c_str());
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+
+    std::vector<ShapeFn> fns;
+    std::vector<double>  weights;
+    for (size_t pos = 0; pos < mix.length();) {
+        size_t end = mix.find(',', pos);
+        if (end == std::string::npos) end = mix.length();
+        auto item = mix.substr(pos, end - pos);
+        auto eq   = item.find('=');
+        auto it   = shapes.find(item.substr(0, eq));
+        if (it == shapes.end()) { fprintf(stderr, "unknown shape in '%s'\n", item.c_str()); return 1; }
+        fns.push_back(it->second);
+        weights.push_back(eq == std::string::npos ? 1 : atof(item.c_str() + eq + 1));
+        pos = end + 1;
+    }
+    if (fns.empty()) { fprintf(stderr, "empty mix\n"); return 1; }
+
+    FILE* out = outfile ? fopen(outfile, "w") : stdout;
+    if (!out) { perror(outfile); return 1; }
+
+    Generator gen(seed);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    for (size_t i = 0; i < count; ++i) {
+        auto line = (gen.*fns[pick(gen.rnd)])();
+        fwrite(line.data(), 1, line.length(), out);
+        fputc('\n', out);
+    }
+    if (outfile) fclose(out);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "bench.h"
+#include <panda/uri/encode.h>
+
+using namespace panda;
+using namespace panda::uri;
+
+static string make_input (size_t len, int unsafe_every) {
+    string ret;
+    for (size_t i = 0; i < len; ++i) ret += (unsafe_every && i % unsafe_every == 0) ? ' ' : char('a' + i % 26);
+    return ret;
+}
+
+BENCH("encode") {
+    for (size_t len : {16, 256, 4096}) for (int unsafe_every : {0, 8}) {
+        string src = make_input(len, unsafe_every);
+        char* buf = new char[len * 3];
+        state.bytes = len;
+        state.run(string::from_number(len) + (unsafe_every ? "/mixed" : "/safe"), [&]{
+            bench::keep(encode_uri_component(string_view(src), buf));
+        });
+        state.run(string::from_number(len) + (unsafe_every ? "/mixed" : "/safe") + "/string", [&]{
+            auto res = encode_uri_component(src);
+            bench::keep(res);
+        });
+        delete[] buf;
+    }
+}
+
+BENCH("decode") {
+    for (size_t len : {16, 256, 4096}) for (int unsafe_every : {0, 8}) {
+        string src = encode_uri_component(make_input(len, unsafe_every));
+        char* buf = new char[src.length()];
+        state.bytes = src.length();
+        state.run(string::from_number(len) + (unsafe_every ? "/mixed" : "/clean"), [&]{
+            bench::keep(decode_uri_component(string_view(src), buf));
+        });
+        delete[] buf;
+    }
+}
+
+BENCH("encoded_length") {
+    for (size_t len : {16, 256, 4096}) {
+        string src = make_input(len, 8);
+        state.bytes = len;
+        state.run(string::from_number(len), [&]{
+            bench::keep(encoded_length(src));
+        });
+    }
+}
@@ -0,0 +1,93 @@
+#include "bench.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <panda/uri/encode.h>
+
+using namespace bench;
+
+static std::vector<std::pair<const char*, Func>>& registry () {
+    static std::vector<std::pair<const char*, Func>> ret;
+    return ret;
+}
+
+bench::Registrar::Registrar (const char* group, Func f) { registry().push_back({group, f}); }
+
+static void usage () {
+    fprintf(stderr,
+        "usage: panda-uri-bench [--format=text|json|csv] [--min-time=SEC] [--repetitions=N] [--out=FILE] [FILTER]\n"
+        "       panda-uri-bench corpus [--format=text|json] [--passes=N] [--ext] FILE\n"
+        "       panda-uri-bench generate [--count=N] [--seed=N] [--mix=SHAPE=WEIGHT,...] [--out=FILE]\n"
+        "       panda-uri-bench scaling [--threads=N] [--time=SEC] [--format=text|json] [FILTER]\n"
+        "runs benchmarks whose name contains FILTER, replays newline-delimited URI corpus, generates synthetic one\n"
+        "or measures multi-threaded scaling\n"
+    );
+}
+
+static void print_text (FILE* out, const std::vector<Result>& results) {
+    fprintf(out, "%-44s %12s %14s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "MB/s", "allocs/op", "alloc B/op");
+    for (auto& r : results) {
+        fprintf(out, "%-44s %12llu %14.2f ", r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op);
+        if (r.bytes_per_sec) fprintf(out, "%12.1f ", r.bytes_per_sec / 1e6);
+        else                 fprintf(out, "%12s ", "-");
+        fprintf(out, "%12.2f %12.1f\n", r.allocs_per_op, r.alloc_bytes_per_op);
+    }
+}
+
+static void print_csv (FILE* out, const std::vector<Result>& results) {
+    fprintf(out, "name,iterations,ns_per_op,bytes_per_sec,allocs_per_op,alloc_bytes_per_op\n");
+    for (auto& r : results) {
+        fprintf(out, "%s,%llu,%.3f,%.0f,%.3f,%.1f\n", r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op, r.bytes_per_sec, r.allocs_per_op, r.alloc_bytes_per_op);
+    }
+}
+
+static void print_json (FILE* out, const std::vector<Result>& results) {
+    fprintf(out, "{\n  \"simd_level\": \"%s\",\n  \"counts_malloc\": %s,\n  \"benchmarks\": [\n",
+            panda::uri::simd_level_name(panda::uri::simd_level()), alloc_counter::counts_malloc() ? "true" : "false");
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"bytes_per_sec\": %.0f, \"allocs_per_op\": %.3f, \"alloc_bytes_per_op\": %.1f}%s\n",
+                r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op, r.bytes_per_sec, r.allocs_per_op, r.alloc_bytes_per_op,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+int corpus_main   (int argc, char** argv);
+int generate_main (int argc, char** argv);
+int scaling_main  (int argc, char** argv);
+
+int main (int argc, char** argv) {
+    if (argc > 1 && !strcmp(argv[1], "corpus"))   return corpus_main(argc - 1, argv + 1);
+    if (argc > 1 && !strcmp(argv[1], "generate")) return generate_main(argc - 1, argv + 1);
+    if (argc > 1 && !strcmp(argv[1], "scaling"))  return scaling_main(argc - 1, argv + 1);
+
+    Config config;
+    std::string format = "text";
+    const char* outfile = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if      (!strncmp(arg, "--format=", 9))      format             = arg + 9;
+        else if (!strncmp(arg, "--min-time=", 11))   config.min_time    = atof(arg + 11);
+        else if (!strncmp(arg, "--repetitions=", 14)) config.repetitions = std::max(1, atoi(arg + 14));
+        else if (!strncmp(arg, "--out=", 6))         outfile            = arg + 6;
+        else if (arg[0] == '-') { usage(); return 1; }
+        else config.filter = arg;
+    }
+    if (format != "text" && format != "json" && format != "csv") { usage(); return 1; }
+
+    std::vector<Result> results;
+    for (auto& row : registry()) {
+        State state(row.first, config, results);
+        row.second(state);
+    }
+
+    FILE* out = outfile ? fopen(outfile, "w") : stdout;
+    if (!out) { perror(outfile); return 1; }
+    if      (format == "json") print_json(out, results);
+    else if (format == "csv")  print_csv(out, results);
+    else                       print_text(out, results);
+    if (outfile) fclose(out);
+    return 0;
+}
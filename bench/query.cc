@@ -0,0 +1,65 @@
+#include "bench.h"
+#include <panda/uri/all.h>
+
+using namespace panda;
+using namespace panda::uri;
+
+static string make_query (int n, bool encoded) {
+    string ret;
+    for (int i = 0; i < n; ++i) {
+        if (i) ret += '&';
+        ret += "key" + string::from_number(i) + '=' + (encoded ? "some%20value%2C" : "some_value_") + string::from_number(i);
+    }
+    return ret;
+}
+
+BENCH("parse_query") {
+    for (int n : {1, 8, 64}) for (bool encoded : {false, true}) {
+        string qstr = make_query(n, encoded);
+        state.bytes = qstr.length();
+        state.run(string::from_number(n) + (encoded ? "/encoded" : "/plain"), [&]{
+            URI uri;
+            uri.query_string(qstr);
+            bench::keep(uri.query());
+        });
+    }
+}
+
+BENCH("compile_query") {
+    for (int n : {1, 8, 64}) for (bool encoded : {false, true}) {
+        URI src;
+        src.query_string(make_query(n, encoded));
+        Query query = src.query();
+        state.bytes = src.query_string().length();
+        state.run(string::from_number(n) + (encoded ? "/encoded" : "/plain"), [&]{
+            URI uri;
+            uri.query(query);
+            bench::keep(uri.query_string());
+        });
+    }
+}
+
+BENCH("param") {
+    URI uri("http://example.com/?" + make_query(16, false));
+    uri.query();
+    state.run("read", [&]{
+        auto val = uri.param("key7");
+        bench::keep(val);
+    });
+    state.run("write", [&]{
+        uri.param("key7", "new_value");
+        bench::keep(uri);
+    });
+}
+
+BENCH("query_writer") {
+    for (int n : {1, 8, 64}) {
+        string out;
+        state.run(string::from_number(n), [&]{
+            out.clear();
+            QueryWriter w(out);
+            for (int i = 0; i < n; ++i) w.add("key", i);
+            bench::keep(out);
+        });
+    }
+}
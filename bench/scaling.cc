@@ -0,0 +1,186 @@
+#include "bench.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <panda/uri/all.h>
+
+// Multi-core scaling: every workload runs on 1, 2, 4, ... N threads for a fixed time, either on one URI shared by all
+// threads or on a private copy per thread, and reports throughput and scaling efficiency relative to 1 thread.
+// Shared URIs are only accessed through const methods and have their lazy caches (query string, query, to_string)
+// synced up front: lazy sync and refcount changes (copying URISP or strings) are not thread-safe, so the shared mode
+// measures cache line sharing of read-only data, while anything that writes must use the local mode.
+// Refcount traffic (urisp_copy, to_string) and lazy sync (lazy_query, lazy_string) are therefore measured on per-thread
+// objects only: doing the same on a shared URI or URISP would be a data race, not contention.
+
+using namespace panda;
+using namespace panda::uri;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+    const char* const source =
+        "https://www.example.com:8443/path/to/resource.html?utm_source=news&utm_medium=email&id=12345&q=a%20b#section";
+
+    struct Env {
+        const URI&    uri; // shared URI or thread's own one, synced before the run
+        URI&          own; // thread's own URI, the only one that workloads may write to
+        const URISP&  ptr; // thread's own typed URI
+        const string& src; // thread's own copy of the source
+        char*         buf;
+    };
+
+    struct Workload {
+        const char* name;
+        bool        shareable; // false if each operation writes to the URI or to a refcount
+        void      (*op)(Env& env);
+    };
+
+    const Workload workloads[] = {
+        {"parse",       false, [](Env& env) {
+            URI uri(env.src);
+            bench::keep(uri);
+        }},
+        {"create",      false, [](Env& env) { // scheme lookup + typed URI allocation
+            URISP uri = URI::create(env.src);
+            bench::keep(uri);
+        }},
+        {"query",       true,  [](Env& env) {
+            bench::keep(env.uri.param("utm_source"));
+            bench::keep(env.uri.param("missing"));
+        }},
+        {"serialize",   true,  [](Env& env) {
+            char* end = env.uri.serialize_to(env.buf);
+            bench::keep(end);
+        }},
+        {"to_string",   false, [](Env& env) { // copies cached string: refcount traffic
+            auto str = env.uri.to_string();
+            bench::keep(str);
+        }},
+        {"urisp_copy",  false, [](Env& env) { // Refcnt increment and decrement
+            URISP copy = env.ptr;
+            bench::keep(copy);
+        }},
+        {"lazy_query",  false, [](Env& env) { // resetting query string drops parsed query, param() parses it again
+            string qstr = env.own.query_string();
+            env.own.query_string(qstr);
+            bench::keep(env.own.param("utm_source"));
+        }},
+        {"lazy_string", false, [](Env& env) { // resetting path drops cached string, to_string() builds it again
+            string path = env.own.path();
+            env.own.path(path);
+            auto str = env.own.to_string();
+            bench::keep(str);
+        }},
+    };
+
+    struct Point {
+        const char* workload;
+        const char* mode;
+        unsigned    threads;
+        double      ops_per_sec;
+        double      efficiency; // ops_per_sec / (threads * ops_per_sec on 1 thread)
+    };
+
+    struct alignas(64) Counter {
+        uint64_t ops = 0;
+    };
+
+    void warm_up (const URI& uri) {
+        uri.query_string();
+        uri.query();
+        uri.to_string();
+    }
+}
+
+static double measure (const Workload& w, bool shared, unsigned nthreads, double seconds) {
+    URI shared_uri(source);
+    warm_up(shared_uri);
+
+    std::atomic<unsigned> ready(0);
+    std::atomic<bool>     go(false), stop(false);
+    std::vector<Counter>  counters(nthreads);
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < nthreads; ++t) threads.emplace_back([&, t]{
+        string src(source, strlen(source)); // private buffer, substrings of it must not be shared between threads
+        URI local(src);
+        warm_up(local);
+        URISP ptr = URI::create(src);
+        char buf[512];
+        Env env = {shared ? shared_uri : local, local, ptr, src, buf};
+
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+        uint64_t n = 0;
+        do {
+            for (int i = 0; i < 64; ++i) w.op(env);
+            n += 64;
+        } while (!stop.load(std::memory_order_relaxed));
+        counters[t].ops = n;
+    });
+
+    while (ready.load() != nthreads) std::this_thread::yield();
+    auto start = clock_type::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    uint64_t total = 0;
+    for (auto& c : counters) total += c.ops;
+    return total / elapsed;
+}
+
+int scaling_main (int argc, char** argv) {
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    double seconds = 0.5;
+    std::string format = "text";
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if      (!strncmp(arg, "--threads=", 10)) max_threads = std::max(1, atoi(arg + 10));
+        else if (!strncmp(arg, "--time=", 7))     seconds     = atof(arg + 7);
+        else if (!strncmp(arg, "--format=", 9))   format      = arg + 9;
+        else if (arg[0] != '-')                   filter      = arg;
+        else { fprintf(stderr, "unknown option %s\n", arg); return 1; }
+    }
+    if (format != "text" && format != "json") {
+        fprintf(stderr, "usage: panda-uri-bench scaling [--threads=N] [--time=SEC] [--format=text|json] [FILTER]\n");
+        return 1;
+    }
+
+    std::vector<unsigned> counts;
+    for (unsigned n = 1; n < max_threads; n *= 2) counts.push_back(n);
+    counts.push_back(max_threads);
+
+    std::vector<Point> points;
+    for (auto& w : workloads) {
+        if (std::string(w.name).find(filter) == std::string::npos) continue;
+        for (int shared = 0; shared <= int(w.shareable); ++shared) {
+            double base = 0;
+            for (auto n : counts) {
+                double ops = measure(w, shared, n, seconds);
+                if (n == 1) base = ops;
+                points.push_back({w.name, shared ? "shared" : "local", n, ops, ops / (n * base)});
+            }
+        }
+    }
+
+    if (format == "json") {
+        printf("{\n  \"hardware_concurrency\": %u,\n  \"seconds\": %.3f,\n  \"points\": [\n", std::thread::hardware_concurrency(), seconds);
+        for (size_t i = 0; i < points.size(); ++i) {
+            auto& p = points[i];
+            printf("    {\"workload\": \"%s\", \"mode\": \"%s\", \"threads\": %u, \"ops_per_sec\": %.0f, \"efficiency\": %.3f}%s\n",
+                   p.workload, p.mode, p.threads, p.ops_per_sec, p.efficiency, i + 1 < points.size() ? "," : "");
+        }
+        printf("  ]\n}\n");
+    } else {
+        printf("%-12s %-8s %8s %16s %12s\n", "workload", "mode", "threads", "ops/s", "efficiency");
+        for (auto& p : points) printf("%-12s %-8s %8u %16.0f %11.1f%%\n", p.workload, p.mode, p.threads, p.ops_per_sec, p.efficiency * 100);
+    }
+    return 0;
+}
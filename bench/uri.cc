@@ -0,0 +1,87 @@
+#include "bench.h"
+#include <panda/uri/all.h>
+
+using namespace panda;
+using namespace panda::uri;
+
+namespace {
+    struct Shape {
+        const char* name;
+        string      uri;
+    };
+}
+
+static std::vector<Shape> shapes () {
+    string tracking = "https://ads.example.com/click/v2?campaign=spring_sale";
+    for (int i = 0; i < 24; ++i) tracking += "&utm_param" + string::from_number(i) + "=value_" + string::from_number(i * 7919);
+    return {
+        {"simple",   "http://example.com/"},
+        {"typical",  "https://www.example.com:8443/path/to/resource.html?query=value&foo=bar#section"},
+        {"ipv6",     "ftp://user:secret@[2001:db8::1]:2121/pub/file.tar.gz"},
+        {"percent",  "http://example.com/%D0%BF%D1%80%D0%B8%D0%B2%D0%B5%D1%82/%E4%BD%A0%E5%A5%BD?q=%20%21%40&x=%2F"},
+        {"tracking", tracking},
+    };
+}
+
+BENCH("parse/strict") {
+    for (auto& shape : shapes()) {
+        state.bytes = shape.uri.length();
+        state.run(shape.name, [&]{
+            URI uri(shape.uri);
+            bench::keep(uri);
+        });
+    }
+}
+
+BENCH("parse/ext") {
+    auto list = shapes();
+    list.push_back({"extended", "http://example.com/search?param={\"key\",\"val|hi\"}&q=a^b"});
+    for (auto& shape : list) {
+        state.bytes = shape.uri.length();
+        state.run(shape.name, [&]{
+            URI uri(shape.uri, URI::Flags::allow_extended_chars);
+            bench::keep(uri);
+        });
+    }
+}
+
+BENCH("to_string") {
+    for (auto& shape : shapes()) {
+        URI uri(shape.uri);
+        state.bytes = shape.uri.length();
+        state.run(string(shape.name) + "/cached", [&]{
+            auto str = uri.to_string();
+            bench::keep(str);
+        });
+        state.run(string(shape.name) + "/rebuilt", [&]{
+            uri.path(uri.path()); // drops cached string
+            auto str = uri.to_string();
+            bench::keep(str);
+        });
+    }
+}
+
+BENCH("path_segments") {
+    URI uri("http://example.com/api/v2/users/12345/repositories/panda-uri/branches/master");
+    state.bytes = uri.path().length();
+    state.run("get", [&]{
+        auto segments = uri.path_segments();
+        bench::keep(segments);
+    });
+    auto segments = uri.path_segments();
+    state.run("set", [&]{
+        uri.path_segments(segments.begin(), segments.end());
+        bench::keep(uri);
+    });
+}
+
+BENCH("create") {
+    for (auto scheme : {"http", "https", "ws", "wss", "ftp", "socks5", "ssh", "telnet", "sftp", "unknown"}) {
+        string src = string(scheme) + "://user@host.example.com:1234/some/path?a=b";
+        state.bytes = src.length();
+        state.run(scheme, [&]{
+            auto uri = URI::create(src);
+            bench::keep(uri);
+        });
+    }
+}
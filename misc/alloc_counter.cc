@@ -0,0 +1,73 @@
+#include "alloc_counter.h"
+#include <new>
+#include <cstdlib>
+
+namespace alloc_counter {
+
+static thread_local Stats _stats;
+
+static inline void count (size_t size) {
+    ++_stats.allocs;
+    _stats.bytes += size;
+}
+
+Stats current () { return _stats; }
+
+#ifdef __GLIBC__
+
+bool counts_malloc () { return true; }
+
+}
+
+extern "C" {
+    void* __libc_malloc   (size_t);
+    void* __libc_calloc   (size_t, size_t);
+    void* __libc_realloc  (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+
+    void* malloc (size_t size) {
+        alloc_counter::count(size);
+        return __libc_malloc(size);
+    }
+
+    void* calloc (size_t n, size_t size) {
+        alloc_counter::count(n * size);
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc (void* ptr, size_t size) {
+        alloc_counter::count(size);
+        return __libc_realloc(ptr, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size) {
+        alloc_counter::count(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign (void** ptr, size_t alignment, size_t size) {
+        alloc_counter::count(size);
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr ? 0 : 12; // ENOMEM
+    }
+}
+
+#else
+
+bool counts_malloc () { return false; }
+
+}
+
+void* operator new (size_t size) {
+    alloc_counter::count(size);
+    if (void* ret = std::malloc(size)) return ret;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size) { return operator new(size); }
+void  operator delete   (void* ptr) noexcept { std::free(ptr); }
+void  operator delete[] (void* ptr) noexcept { std::free(ptr); }
+void  operator delete   (void* ptr, size_t) noexcept { std::free(ptr); }
+void  operator delete[] (void* ptr, size_t) noexcept { std::free(ptr); }
+
+#endif
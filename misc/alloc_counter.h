@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+// Counts heap allocations made by the calling thread. On glibc malloc family is interposed, so that allocations made
+// by panda::string (which uses malloc directly) are counted too; elsewhere only operator new is counted.
+namespace alloc_counter {
+
+struct Stats {
+    uint64_t allocs = 0;
+    uint64_t bytes  = 0;
+};
+
+Stats current ();
+bool  counts_malloc (); // false if only operator new is hooked
+
+}
@@ -0,0 +1,61 @@
+#include <panda/uri/FormParser.h>
+#include <cstring>
+
+namespace panda { namespace uri {
+
+void FormParser::feed (const string_view& chunk) {
+    const char* p   = chunk.data();
+    const char* end = p + chunk.length();
+    if (p != end) _fed = true;
+
+    while (p != end) {
+        if (_state == State::key) {
+            const char* stop = p;
+            while (stop != end && *stop != '=' && *stop != _delim) ++stop;
+            if (_raw_key.length() + (stop - p) > max_key_length) throw URIError("form key is too long");
+            _raw_key.append(p, stop - p);
+            if (stop == end) return;
+            p = stop + 1;
+            start_value();
+            if (*stop == _delim) end_value();
+            continue;
+        }
+
+        auto stop = (const char*)memchr(p, _delim, end - p);
+        auto vend = stop ? stop : end;
+        if (_state == State::value && vend != p) {
+            _piece.clear();
+            _decoder.decode(string_view(p, vend - p), _piece);
+            if (_piece) on_value(_key, _piece, false);
+        }
+        if (!stop) return;
+        p = stop + 1;
+        end_value();
+    }
+}
+
+void FormParser::finish () {
+    if (_fed) { // end of input works as delimiter, like in URI::parse_query()
+        if (_state == State::key) start_value();
+        end_value();
+    }
+    _fed = false;
+}
+
+void FormParser::start_value () {
+    _key.clear();
+    decode_uri_component(string_view(_raw_key), _key);
+    _raw_key.clear();
+    _state = (on_value && (!filter || filter(_key))) ? State::value : State::skip;
+}
+
+void FormParser::end_value () {
+    if (_state == State::value) {
+        _piece.clear();
+        _decoder.finish(_piece);
+        on_value(_key, _piece, true);
+    }
+    _state = State::key;
+}
+
+}}
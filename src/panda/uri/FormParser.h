@@ -0,0 +1,44 @@
+#pragma once
+#include <functional>
+#include <panda/string.h>
+#include <panda/string_view.h>
+#include <panda/uri/URI.h>
+#include <panda/uri/encode.h>
+
+namespace panda { namespace uri {
+
+// Streaming parser of application/x-www-form-urlencoded data (like request bodies or query strings).
+// Input is fed by chunks split at arbitrary points, pairs are tokenized the same way as URI::parse_query() does and are
+// reported as soon as they are available, so that memory use doesn't depend on input size. Unlike parse_query(), '+' is
+// always decoded as space. Keys are buffered whole (up to max_key_length raw bytes, URIError is thrown for longer ones),
+// values are decoded and passed to on_value in pieces, the last piece of each value has last == true.
+struct FormParser {
+    using Filter       = std::function<bool(const string& key)>;
+    using ValueHandler = std::function<void(const string& key, const string_view& piece, bool last)>;
+
+    Filter       filter;   // pairs whose key is rejected by filter are skipped without decoding
+    ValueHandler on_value;
+    size_t       max_key_length = 4096;
+
+    FormParser (char delim = '&') : _delim(delim) {}
+    FormParser (ValueHandler on_value, char delim = '&') : on_value(std::move(on_value)), _delim(delim) {}
+
+    void feed   (const string_view& chunk);
+    void finish (); // end of input, parser is ready for the next one afterwards
+
+private:
+    enum class State { key, value, skip };
+
+    char          _delim;
+    State         _state = State::key;
+    bool          _fed   = false;
+    string        _raw_key;
+    string        _key;
+    string        _piece;
+    StreamDecoder _decoder;
+
+    void start_value ();
+    void end_value   ();
+};
+
+}}
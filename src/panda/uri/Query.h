@@ -19,6 +19,12 @@ struct Query : panda::string_multimap<string, string> {
         return *this;
     }
 
+    Query& operator= (Query&& x) {
+        rev++;
+        Base::operator=(std::move(x));
+        return *this;
+    }
+
     iterator insert (const value_type& val)                        { rev++; return Base::insert(val); }
     template <class P>
     iterator insert (P&& value)                                    { rev++; return Base::insert(std::forward(value)); }
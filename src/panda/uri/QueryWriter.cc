@@ -0,0 +1,37 @@
+#include <panda/uri/QueryWriter.h>
+#include <algorithm>
+
+namespace panda { namespace uri {
+
+QueryWriter::QueryWriter (URI& uri) : _dest(uri._qstr), _uri(&uri), _delim(uri._flags & URI::Flags::query_param_semicolon ? ';' : '&') {}
+
+QueryWriter& QueryWriter::add (const string_view& key, const string_view& value) {
+    char* ptr = start_pair(encoded_length(key) + 1 + encoded_length(value));
+    ptr += encode_uri_component(key, ptr);
+    *ptr++ = '=';
+    ptr += encode_uri_component(value, ptr);
+    finish_pair(ptr);
+    return *this;
+}
+
+char* QueryWriter::start_pair (size_t maxlen) {
+    if (_uri) _uri->sync_query_string();
+
+    size_t len = _dest.length();
+    bool need_delim = len && _dest[len-1] != '?' && _dest[len-1] != _delim;
+    size_t need = len + need_delim + maxlen;
+    if (need > _dest.capacity()) _dest.reserve(std::max(need, _dest.capacity() * 2)); // amortize growth over many pairs
+
+    char* ptr = _dest.buf() + len;
+    if (need_delim) *ptr++ = _delim;
+    return ptr;
+}
+
+void QueryWriter::finish_pair (char* end) {
+    _dest.length(end - _dest.data());
+    if (!_uri) return;
+    _uri->ok_qstr();
+    _uri->invalidate();
+}
+
+}}
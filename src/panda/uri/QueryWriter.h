@@ -0,0 +1,42 @@
+#pragma once
+#include <type_traits>
+#include <panda/string.h>
+#include <panda/string_view.h>
+#include <panda/from_chars.h>
+#include <panda/uri/URI.h>
+#include <panda/uri/encode.h>
+
+namespace panda { namespace uri {
+
+// Appends encoded key=value pairs straight to a string or to URI's query string, without building Query.
+// Delimiter is not written before the first pair if dest is empty or ends with '?' or delimiter.
+struct QueryWriter {
+    QueryWriter (string& dest, char delim = '&') : _dest(dest), _uri(nullptr), _delim(delim) {}
+    QueryWriter (URI& uri);
+
+    QueryWriter& add (const string_view& key, const string_view& value);
+
+    template <class T, typename = typename std::enable_if<
+        std::is_integral<T>::value && !std::is_same<T,bool>::value && !std::is_same<T,char>::value
+    >::type>
+    QueryWriter& add (const string_view& key, T value) {
+        char* ptr = start_pair(encoded_length(key) + 1 + max_digits);
+        ptr += encode_uri_component(key, ptr);
+        *ptr++ = '=';
+        ptr = to_chars(ptr, ptr + max_digits, value).ptr;
+        finish_pair(ptr);
+        return *this;
+    }
+
+private:
+    static constexpr const size_t max_digits = 20; // any 64-bit value including sign
+
+    string& _dest;
+    URI*    _uri;
+    char    _delim;
+
+    char* start_pair  (size_t maxlen); // reserves room and writes delimiter if needed, returns position to write pair to
+    void  finish_pair (char* end);
+};
+
+}}
@@ -1,25 +1,70 @@
 #pragma once
+#include <type_traits>
 #include <panda/uri/URI.h>
 
 namespace panda { namespace uri {
 
 struct URIStrict : URI {
     using URI::URI;
-    URIStrict (const URI& source) : URI(source) {}
+    URIStrict (const URI& source) : URI(source)            {}
+    URIStrict (URI&& source)      : URI(std::move(source)) {}
 };
 
 template <class TYPE1, class TYPE2>
 struct URI::Strict : URIStrict {
-    Strict ()                                    : URIStrict()              {}
-    Strict (const string& source, int flags = 0) : URIStrict(source, flags) { strict_scheme(); }
-    Strict (const URI& source)                   : URIStrict(source)        { strict_scheme(); }
+    Strict ()                                    : URIStrict()                  {}
+    Strict (const string& source, int flags = 0) : URIStrict()                  { assign(source, flags); }
+    Strict (const URI& source)                   : URIStrict(source)            { strict_scheme(); }
+    Strict (URI&& source)                        : URIStrict(std::move(source)) { strict_scheme(); }
+    Strict (const Strict&)     = default;
+    Strict (Strict&&) noexcept = default;
+
+    // assignment and parsing call Strict's members directly, so that for final scheme types nothing is dispatched virtually.
+    // Moving from the same type needs no scheme check, so it never throws and containers move instead of copying
+    Strict& operator= (const Strict& source)     { return *this = static_cast<const URI&>(source); }
+    Strict& operator= (Strict&& source) noexcept { if (this != &source) move_from(source);                  return *this; }
+    Strict& operator= (const URI& source)        { if (this != &source) Strict::assign(source);            return *this; }
+    Strict& operator= (URI&& source)             { if (this != &source) Strict::assign(std::move(source)); return *this; }
+    Strict& operator= (const string& source)     { Strict::assign(source); return *this; }
 
     using URI::assign;
+    void assign (const string& source, int flags = 0) {
+        clear();
+        _flags = flags;
+        Strict::parse(source);
+    }
+
+    using URI::try_assign;
+    // returns false on wrong scheme and on invalid input, leaving URI empty
+    bool try_assign (const string& source, ParseError& err, int flags = 0) override {
+        clear();
+        _flags = flags;
+        err = URI::parse(source, scheme_filter());
+        if (!err && _scheme && !accepts(scheme_info)) err = {ParseError::wrong_scheme, _scheme.length()}; // filter was not installed
+        if (err) {
+            clear();
+            return false;
+        }
+        strict_scheme();
+        return true;
+    }
+
+    static TYPE1 try_parse (const string& source, ParseError& err, int flags = 0) {
+        TYPE1 ret;
+        ret.try_assign(source, err, flags);
+        return ret;
+    }
+
     void assign (const URI& source) override {
         URI::assign(source);
         strict_scheme();
     }
 
+    void assign (URI&& source) override {
+        URI::assign(std::move(source));
+        strict_scheme();
+    }
+
     using URI::scheme;
     void scheme (const string& scheme) override {
         URI::scheme(scheme);
@@ -27,18 +72,34 @@ struct URI::Strict : URIStrict {
     }
 
 protected:
+    // wrong scheme stops the parser right after the scheme instead of parsing the rest to throw after
     void parse (const string& uristr) override {
-        URI::parse(uristr);
+        if (URI::parse(uristr, scheme_filter()).kind == ParseError::wrong_scheme) wrong_scheme();
         strict_scheme();
     }
 
+    // with allow_suffix_reference "host:port" looks like a scheme to the parser, so the check is left to strict_scheme()
+    // after guess_suffix_reference()
+    schemefilter scheme_filter () const {
+        return _flags & Flags::allow_suffix_reference ? nullptr : &accepts_scheme;
+    }
+
+    static bool accepts (const SchemeInfo* si) {
+        if (!si || si->type_id < 0) return false;
+        return si->type_id == type_id<TYPE1>() || (!std::is_void<TYPE2>::value && si->type_id == type_id<TYPE2>());
+    }
+
+    static bool accepts_scheme (const string& scheme) { return accepts(find_scheme_info(scheme)); }
+
     void strict_scheme () {
         if (!_scheme.length()) {
             if (_host.length()) URI::scheme(TYPE1::default_scheme());
         }
-        else if (!scheme_info || (*(scheme_info->type_info) != typeid(TYPE1) && *(scheme_info->type_info) != typeid(TYPE2))) {
-            throw WrongScheme("URI: wrong scheme '" + _scheme + "' for " + typeid(TYPE1).name());
-        }
+        else if (!accepts(scheme_info)) wrong_scheme();
+    }
+
+    void wrong_scheme () {
+        throw WrongScheme("URI: wrong scheme '" + _scheme + "' for " + typeid(TYPE1).name());
     }
 };
 
@@ -1,12 +1,19 @@
 #include <ostream>
+#include <cstring>
+#include <cstddef>
 #include <stdexcept>
 #include <unordered_map>
+#include <typeindex>
 #include <panda/uri/all.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 
 namespace panda { namespace uri {
 
 static std::unordered_map<const string, URI::SchemeInfo> scheme_map;
 static std::map<const std::type_info*, URI::SchemeInfo*> scheme_ti_map;
+static std::unordered_map<std::type_index, int> type_ids;
 static std::vector<URI::SchemeInfo*> schemas;
 
 static URI::SchemeInfo* http_si;
@@ -15,34 +22,48 @@ static URI::SchemeInfo* https_si;
 const string URI::_empty;
 
 void URI::register_scheme (const string& scheme, uint16_t default_port, bool secure) {
-    register_scheme(scheme, &typeid(URI), [](const URI& u)->URI*{ return new URI(u);  }, default_port, secure);
+    register_scheme<URI>(scheme, default_port, secure);
 }
 
 void URI::register_scheme (const string& scheme, const std::type_info* ti, uricreator creator, uint16_t default_port, bool secure) {
-    if (scheme_map.find(scheme) != scheme_map.end())
-        throw std::invalid_argument("URI::register_scheme: scheme '" + scheme + "' has been already registered");
+    register_scheme(scheme, ti, creator, nullptr, default_port, secure);
+}
+
+void URI::register_scheme (const string& scheme, const std::type_info* ti, uricreator creator, urimover mover, uint16_t default_port, bool secure) {
+    if (!try_register_scheme(scheme, ti, creator, mover, default_port, secure)) throw_scheme_registered(scheme);
+}
+
+void URI::throw_scheme_registered (const string& scheme) {
+    throw std::invalid_argument("URI::register_scheme: scheme '" + scheme + "' has been already registered");
+}
+
+bool URI::try_register_scheme (const string& scheme, const std::type_info* ti, uricreator creator, urimover mover, uint16_t default_port, bool secure) {
+    if (scheme_map.find(scheme) != scheme_map.end()) return false;
     auto& inf = scheme_map[scheme];
     inf.index         = schemas.size();
     inf.scheme        = scheme;
     inf.creator       = creator;
+    inf.mover         = mover;
     inf.default_port  = default_port;
     inf.secure        = secure;
     inf.type_info     = ti;
+    inf.type_id       = ti ? type_ids.emplace(*ti, type_ids.size()).first->second : -1; // null type is never accepted by Strict
     scheme_ti_map[ti] = &inf;
     schemas.push_back(&inf);
+    return true;
 }
 
 
 static int init () {
-    URI::register_scheme("http",   &typeid(URI::http),   [](const URI& u)->URI*{ return new URI::http(u);   },   80      );
-    URI::register_scheme("https",  &typeid(URI::https),  [](const URI& u)->URI*{ return new URI::https(u);  },  443, true);
-    URI::register_scheme("ws",     &typeid(URI::ws),     [](const URI& u)->URI*{ return new URI::ws(u);     },   80      );
-    URI::register_scheme("wss",    &typeid(URI::wss),    [](const URI& u)->URI*{ return new URI::wss(u);    },  443, true);
-    URI::register_scheme("ftp",    &typeid(URI::ftp),    [](const URI& u)->URI*{ return new URI::ftp(u);    },   21      );
-    URI::register_scheme("socks5", &typeid(URI::socks),  [](const URI& u)->URI*{ return new URI::socks(u);  }, 1080      );
-    URI::register_scheme("ssh",    &typeid(URI::ssh),    [](const URI& u)->URI*{ return new URI::ssh(u);    },   22, true);
-    URI::register_scheme("telnet", &typeid(URI::telnet), [](const URI& u)->URI*{ return new URI::telnet(u); },   23      );
-    URI::register_scheme("sftp",   &typeid(URI::sftp),   [](const URI& u)->URI*{ return new URI::sftp(u);   },   22, true);
+    URI::register_scheme<URI::http>  ("http",     80      );
+    URI::register_scheme<URI::https> ("https",   443, true);
+    URI::register_scheme<URI::ws>    ("ws",       80      );
+    URI::register_scheme<URI::wss>   ("wss",     443, true);
+    URI::register_scheme<URI::ftp>   ("ftp",      21      );
+    URI::register_scheme<URI::socks> ("socks5", 1080      );
+    URI::register_scheme<URI::ssh>   ("ssh",      22, true);
+    URI::register_scheme<URI::telnet>("telnet",   23      );
+    URI::register_scheme<URI::sftp>  ("sftp",     22, true);
 
     http_si  = &scheme_map.find("http")->second;
     https_si = &scheme_map.find("https")->second;
@@ -52,22 +73,39 @@ static int init () {
 static const int __init = init();
 
 void URI::parse (const string& str) {
-    bool authority_has_pct = false;
-    bool ok = !(_flags & Flags::allow_extended_chars) ? _parse(str, authority_has_pct) : _parse_ext(str, authority_has_pct);
+    parse(str, nullptr);
+}
+
+ParseError URI::parse (const string& str, schemefilter filter) {
+    invalidate();
+    ParseContext ctx = {filter, false, false, 0};
+    bool ok = !(_flags & Flags::allow_extended_chars) ? _parse(str, ctx) : _parse_ext(str, ctx);
+    stats::count(stats::Counter::parse);
+    stats::record(stats::Histogram::uri_length, str.length());
+
+    if (ctx.scheme_rejected) {
+        stats::count(stats::Counter::scheme_rejected);
+        string scheme = _scheme;
+        clear();
+        _scheme = scheme;
+        return {ParseError::wrong_scheme, scheme.length()};
+    }
 
     if (!ok) {
+        stats::count(stats::Counter::parse_failed);
         clear();
-        return;
+        return {ParseError::syntax, ctx.position};
     }
 
-    if (authority_has_pct) {
-        decode_uri_component(_user_info, _user_info);
-        decode_uri_component(_host, _host);
+    if (ctx.authority_has_pct) {
+        decode_uri_component_inplace(_user_info);
+        decode_uri_component_inplace(_host);
     }
 
     if (_qstr) ok_qstr();
     if (_flags & Flags::allow_suffix_reference && !_host.length()) guess_suffix_reference();
     sync_scheme_info();
+    return {};
 }
 
 void URI::guess_suffix_reference () {
@@ -109,53 +147,248 @@ void URI::guess_suffix_reference () {
     _path.erase(0, i);
 }
 
-string URI::to_string (bool relative) const {
+static inline char* _copy (char* dest, const char* src, size_t len) {
+    memcpy(dest, src, len);
+    return dest + len;
+}
+
+static inline size_t _port_digits (uint16_t port) {
+    return port < 10 ? 1 : port < 100 ? 2 : port < 1000 ? 3 : port < 10000 ? 4 : 5;
+}
+
+static inline bool _is_ip_literal (const string& host) {
+    return host.front() == '[' && host.back() == ']';
+}
+
+size_t URI::prefix_length () const {
+    size_t len = 0;
+    if (_scheme) len += _scheme.length() + (_host ? 3 : 1);
+    else if (_host) len += 2;
+
+    if (_host) {
+        if (_user_info) len += encoded_length(_user_info, URIComponent::user_info) + 1;
+        len += _is_ip_literal(_host) ? _host.length() : encoded_length(_host, URIComponent::host);
+    }
+    return len;
+}
+
+size_t URI::port_length () const {
+    return (_host && _port) ? _port_digits(_port) + 1 : 0;
+}
+
+char* URI::write_prefix (char* dest) const {
+    if (_scheme) {
+        dest = _copy(dest, _scheme.data(), _scheme.length());
+        if (_host) dest = _copy(dest, "://", 3);
+        else *dest++ = ':';
+    }
+    else if (_host) dest = _copy(dest, "//", 2);
+
+    if (_host) {
+        if (_user_info) {
+            dest += encode_uri_component(_user_info, dest, URIComponent::user_info);
+            *dest++ = '@';
+        }
+
+        if (_is_ip_literal(_host)) dest = _copy(dest, _host.data(), _host.length());
+        else dest += encode_uri_component(_host, dest, URIComponent::host);
+    }
+    return dest;
+}
+
+char* URI::write_port (char* dest) const {
+    if (!_host || !_port) return dest;
+    *dest++ = ':';
+    auto res = to_chars(dest, dest + 5, _port);
+    assert(!res.ec); // port is 5 chars max
+    return res.ptr;
+}
+
+size_t URI::serialized_length (bool relative) const {
+    sync_query_string();
+    if (_str) return relative ? _str.length() - _str_path + !_path : _str.length();
+
+    size_t len = _path ? _path.length() : relative; // relative path MUST NOT be empty
+    if (_qstr)     len += _qstr.length() + 1;
+    if (_fragment) len += _fragment.length() + 1;
+    if (!relative) len += prefix_length() + port_length();
+    return len;
+}
+
+char* URI::serialize_to (char* dest, bool relative) const {
     sync_query_string();
-    size_t approx_len = _path.length() + _fragment.length() + _qstr.length() + 3;
-    if (!relative) approx_len += (_scheme.length()+3) + (_user_info.length()*3 + 1) + (_host.length()*3 + 6);
-    string str(approx_len);
+    if (_str) {
+        if (!relative) return _copy(dest, _str.data(), _str.length());
+        if (!_path) *dest++ = '/';
+        return _copy(dest, _str.data() + _str_path, _str.length() - _str_path);
+    }
+
+    if (!relative) dest = write_port(write_prefix(dest));
+    return write_tail(dest, relative);
+}
+
+char* URI::write_tail (char* dest, bool relative) const {
+    if (_path) dest = _copy(dest, _path.data(), _path.length());
+    else if (relative) *dest++ = '/'; // relative path MUST NOT be empty
+
+    if (_qstr) {
+        *dest++ = '?';
+        dest = _copy(dest, _qstr.data(), _qstr.length()); // as is, because already encoded either by raw_query setter or by compile_query
+    }
+
+    if (_fragment) {
+        *dest++ = '#';
+        dest = _copy(dest, _fragment.data(), _fragment.length());
+    }
+
+    return dest;
+}
+
+void URI::append_to (string& dest, bool relative) const {
+    if (!dest && !relative) { // nothing to append to, just share the cached string
+        dest = to_string();
+        return;
+    }
+    size_t len = dest.length();
+    char* buf = dest.reserve(len + serialized_length(relative));
+    dest.length(serialize_to(buf + len, relative) - buf);
+}
+
+#ifndef _WIN32
+// slices are passed to writev() as is
+static_assert(sizeof(URI::Slice) == sizeof(iovec), "Slice must match iovec");
+static_assert(offsetof(URI::Slice, base) == offsetof(iovec, iov_base), "Slice must match iovec");
+static_assert(offsetof(URI::Slice, len)  == offsetof(iovec, iov_len),  "Slice must match iovec");
+#endif
+
+size_t URI::serialize_slices (Slice* dest, string& buf, bool relative) const {
+    sync_query_string();
+    Slice* slice = dest;
+    auto add = [&slice](const char* ptr, size_t len) {
+        slice->base = ptr;
+        slice->len  = len;
+        ++slice;
+    };
+
+    if (_str) {
+        if (!relative) add(_str.data(), _str.length());
+        else {
+            if (!_path) add("/", 1);
+            if (_str.length() > _str_path) add(_str.data() + _str_path, _str.length() - _str_path);
+        }
+        return slice - dest;
+    }
 
     if (!relative) {
-        if (_scheme.length()) {
-            str += _scheme;
-            if (_host.length()) str += "://";
-            else str += ':';
+        if (_scheme) {
+            add(_scheme.data(), _scheme.length());
+            if (_host) add("://", 3);
+            else       add(":", 1);
         }
-        else if (_host.length()) str += "//";
+        else if (_host) add("//", 2);
+
+        if (_host) {
+            bool ip_literal = _is_ip_literal(_host);
+            size_t ui_len   = _user_info ? encoded_length(_user_info, URIComponent::user_info) : 0;
+            size_t host_len = ip_literal ? _host.length() : encoded_length(_host, URIComponent::host);
+            size_t bufsize  = (ui_len != _user_info.length() ? ui_len : 0) + (host_len != _host.length() ? host_len : 0) + port_length();
+
+            // everything that can't be pointed to is written to buf, which is reserved once so that pointers stay valid
+            char* ptr = nullptr;
+            if (bufsize) {
+                buf.clear();
+                ptr = buf.reserve(bufsize);
+                buf.length(bufsize);
+            }
 
-        if (_host.length()) {
-            if (_user_info.length()) {
-                _encode_uri_component_append(_user_info, str, URIComponent::user_info);
-                str += '@';
+            if (_user_info) {
+                if (ui_len == _user_info.length()) add(_user_info.data(), ui_len);
+                else {
+                    add(ptr, ui_len);
+                    ptr += encode_uri_component(_user_info, ptr, URIComponent::user_info);
+                }
+                add("@", 1);
             }
 
-            const auto& chost = _host;
-            if (chost.front() == '[' && chost.back() == ']') str += _host;
-            else _encode_uri_component_append(_host, str, URIComponent::host);
+            if (host_len == _host.length()) add(_host.data(), host_len);
+            else {
+                add(ptr, host_len);
+                ptr += encode_uri_component(_host, ptr, URIComponent::host);
+            }
 
             if (_port) {
-                str += ':';
-                str += string::from_number(_port);
+                char* end = write_port(ptr);
+                add(ptr, end - ptr);
             }
         }
     }
 
-    if (_path.length()) str += _path;
-    else if (relative) str += '/'; // relative path MUST NOT be empty
+    if (_path)         add(_path.data(), _path.length());
+    else if (relative) add("/", 1); // relative path MUST NOT be empty
 
-    if (_qstr.length()) {
-        str += '?';
-        str += _qstr; // as is, because already encoded either by raw_query setter or by compile_query
+    if (_qstr) {
+        add("?", 1);
+        add(_qstr.data(), _qstr.length());
     }
 
-    if (_fragment.length()) {
-        str += '#';
-        str += _fragment;
+    if (_fragment) {
+        add("#", 1);
+        add(_fragment.data(), _fragment.length());
     }
 
+    return slice - dest;
+}
+
+string URI::to_string (bool relative) const {
+    sync_query_string();
+    if (!_str) build_str();
+    if (!relative) return _str;
+    if (_path) return _str.substr(_str_path);
+
+    string str(_str.length() - _str_path + 1);
+    str += '/'; // relative path MUST NOT be empty
+    str.append(_str, _str_path);
     return str;
 }
 
+void URI::build_str () const {
+    string str;
+    char* buf = str.reserve(serialized_length());
+    char* ptr = write_prefix(buf);
+    _str_port = ptr - buf;
+    ptr = write_port(ptr);
+    _str_path = ptr - buf;
+    ptr = write_tail(ptr, false);
+    _str_frag = (ptr - buf) - (_fragment ? _fragment.length() + 1 : 0);
+    str.length(ptr - buf);
+    _str = str;
+}
+
+void URI::port (uint16_t port) {
+    if (port == _port) return;
+    _port = port;
+    if (!_str || !_host) return; // port is not a part of string without host
+
+    // patch cached string in place instead of rebuilding it
+    char buf[6];
+    size_t len = write_port(buf) - buf;
+    size_t oldlen = _str_path - _str_port;
+    _str.replace(_str_port, oldlen, buf, len);
+    _str_path = _str_path - oldlen + len;
+    _str_frag = _str_frag - oldlen + len;
+}
+
+void URI::sync_fragment () {
+    if (!_str) return;
+
+    // fragment is always the last part, so just replace the tail of cached string
+    _str.erase(_str_frag);
+    if (_fragment) {
+        _str += '#';
+        _str += _fragment;
+    }
+}
+
 void URI::parse_query () const {
     enum { PARSE_MODE_KEY, PARSE_MODE_VAL, PARSE_MODE_WRITE } mode = PARSE_MODE_KEY;
     int key_start = 0;
@@ -166,6 +399,8 @@ void URI::parse_query () const {
     const char* str = _qstr.data();
     int len = _qstr.length();
     _query.clear();
+    stats::count(stats::Counter::parse_query);
+    stats::record(stats::Histogram::query_length, len);
 
     if (len) for (int i = 0; i <= len; ++i) {
         char c = (i == len) ? delim : str[i];
@@ -202,17 +437,19 @@ void URI::parse_query () const {
         }
     }
 
+    stats::record(stats::Histogram::query_params, _query.size());
     ok_qboth();
 }
 
 void URI::compile_query () const {
+    invalidate();
     _qstr.clear();
     const char delim = _flags & Flags::query_param_semicolon ? ';' : '&';
     auto begin = _query.cbegin();
     auto end   = _query.cend();
 
     size_t bufsize = 0;
-    for (auto it = begin; it != end; ++it) bufsize += (it->first.length() + it->second.length())*3 + 2;
+    for (auto it = begin; it != end; ++it) bufsize += encoded_length(it->first) + encoded_length(it->second) + 2;
     if (bufsize) --bufsize;
 
     _qstr.reserve(bufsize);
@@ -226,6 +463,8 @@ void URI::compile_query () const {
         ptr += encode_uri_component(it->second, ptr);
     }
     _qstr.length(ptr-bufp);
+    stats::count(stats::Counter::compile_query);
+    stats::record(stats::Histogram::query_length, _qstr.length());
 
     ok_qboth();
 }
@@ -234,6 +473,7 @@ void URI::add_query (const string& addstr) {
     if (!addstr) return;
     sync_query_string();
     ok_qstr();
+    invalidate();
     if (_qstr) {
         _qstr.reserve(_qstr.length() + addstr.length() + 1);
         _qstr += '&';
@@ -307,6 +547,10 @@ void URI::swap (URI& uri) {
     std::swap(_qrev,       uri._qrev);
     std::swap(_fragment,   uri._fragment);
     std::swap(_flags,      uri._flags);
+    std::swap(_str,        uri._str);
+    std::swap(_str_port,   uri._str_port);
+    std::swap(_str_path,   uri._str_path);
+    std::swap(_str_frag,   uri._str_frag);
 }
 
 void URI::sync_scheme_info () {
@@ -315,13 +559,15 @@ void URI::sync_scheme_info () {
         return;
     }
 
+    // read via const pointer: non-const operator[] would detach the buffer shared with the parsed source
     auto len = _scheme.length();
-    if (len >= 4 && (_scheme[0]|0x20) == 'h' && (_scheme[1]|0x20) == 't' && (_scheme[2]|0x20) == 't' && (_scheme[3]|0x20) == 'p') {
+    const char* s = _scheme.data();
+    if (len >= 4 && (s[0]|0x20) == 'h' && (s[1]|0x20) == 't' && (s[2]|0x20) == 't' && (s[3]|0x20) == 'p') {
         if (len == 4) {
             scheme_info = http_si;
             _scheme = "http";
         }
-        else if (len == 5 && (_scheme[4]|0x20) == 's') {
+        else if (len == 5 && (s[4]|0x20) == 's') {
             scheme_info = https_si;
             _scheme = "https";
             return;
@@ -329,16 +575,43 @@ void URI::sync_scheme_info () {
         return;
     }
 
-    // lowercase the scheme
-    char* p   = _scheme.buf();
-    char* end = p + _scheme.length();
-    for (;p != end; ++p) *p = tolower(*p);
+    // lowercase the scheme, detaching only if there is something to change
+    for (size_t i = 0; i < len; ++i) if (s[i] >= 'A' && s[i] <= 'Z') {
+        stats::count(stats::Counter::scheme_detach);
+        char* p   = _scheme.buf();
+        char* end = p + len;
+        for (p += i; p != end; ++p) *p = tolower(*p);
+        break;
+    }
 
     auto it = scheme_map.find(_scheme);
     if (it == scheme_map.cend()) scheme_info = NULL;
     else                         scheme_info = &it->second;
 }
 
+int URI::type_id (const std::type_info& ti) {
+    auto it = type_ids.find(ti);
+    return it == type_ids.end() ? -1 : it->second;
+}
+
+URI::SchemeInfo* URI::find_scheme_info (const string& scheme) {
+    auto len = scheme.length();
+    const char* s = scheme.data();
+    if (len == 4 && !memcmp(s, "http",  4)) return http_si;
+    if (len == 5 && !memcmp(s, "https", 5)) return https_si;
+
+    for (size_t i = 0; i < len; ++i) if (s[i] >= 'A' && s[i] <= 'Z') {
+        string lower(s, len);
+        char* p = lower.buf();
+        for (size_t j = i; j < len; ++j) p[j] = tolower(p[j]);
+        auto it = scheme_map.find(lower);
+        return it == scheme_map.end() ? nullptr : &it->second;
+    }
+
+    auto it = scheme_map.find(scheme);
+    return it == scheme_map.end() ? nullptr : &it->second;
+}
+
 URI::SchemeInfo* URI::get_scheme_info (const std::type_info* ti) {
     auto it = scheme_ti_map.find(ti);
     return it == scheme_ti_map.end() ? nullptr : it->second;
@@ -351,6 +624,7 @@ string URI::user () const {
 }
 
 void URI::user (const string& user) {
+    invalidate();
     size_t delim = _user_info.find(':');
     if (delim == string::npos) _user_info = user;
     else _user_info.replace(0, delim, user);
@@ -363,6 +637,7 @@ string URI::password () const {
 }
 
 void URI::password (const string& password) {
+    invalidate();
     size_t delim = _user_info.find(':');
     if (delim == string::npos) {
         _user_info += ':';
@@ -372,8 +647,14 @@ void URI::password (const string& password) {
 }
 
 std::ostream& operator<< (std::ostream& os, const URI& uri) {
-    string tmp = uri.to_string();
-    return os.write(tmp.data(), tmp.length());
+    char buf[1024];
+    size_t len = uri.serialized_length();
+    if (len > sizeof(buf)) {
+        string tmp = uri.to_string();
+        return os.write(tmp.data(), tmp.length());
+    }
+    uri.serialize_to(buf);
+    return os.write(buf, len);
 }
 
 }}
@@ -1,5 +1,6 @@
 #pragma once
 #include <map>
+#include <atomic>
 #include <vector>
 #include <cctype>
 #include <iosfwd>
@@ -23,6 +24,16 @@ struct WrongScheme : URIError {
   explicit WrongScheme (const std::string& what_arg) : URIError(what_arg) {}
 };
 
+// failure reported by non-throwing try_* functions
+struct ParseError {
+    enum Kind { none, syntax, wrong_scheme };
+
+    Kind   kind     = none;
+    size_t position = 0; // offset of the character where parsing stopped (end of input if it ended too early)
+
+    explicit operator bool () const { return kind != none; }
+};
+
 struct URI;
 using URISP = iptr<URI>;
 
@@ -37,23 +48,62 @@ struct URI : Refcnt {
     struct http; struct https; struct ftp; struct socks; struct ws; struct wss; struct ssh; struct telnet; struct sftp;
 
     using uricreator = URI*(*)(const URI& uri);
+    using urimover   = URI*(*)(URI&& uri); // optional, makes typed URI from a temporary without copying it
+    using schemefilter = bool(*)(const string& scheme); // scheme as it is in the source, may be not lowercased
+
+    struct Slice { // layout-compatible with POSIX iovec
+        const char* base;
+        size_t      len;
+    };
+    static constexpr const size_t max_slices = 12;
 
     struct SchemeInfo {
         int        index;
         string     scheme;
         uricreator creator;
+        urimover   mover;
         uint16_t   default_port;
         bool       secure;
         const std::type_info* type_info;
+        int        type_id; // see type_id()
     };
 
     static void register_scheme (const string& scheme, uint16_t default_port, bool secure = false);
     static void register_scheme (const string& scheme, const std::type_info*, uricreator, uint16_t default_port, bool secure = false);
+    static void register_scheme (const string& scheme, const std::type_info*, uricreator, urimover, uint16_t default_port, bool secure = false);
+
+    template <class T>
+    static void register_scheme (const string& scheme, uint16_t default_port, bool secure = false) {
+        if (!try_register_scheme<T>(scheme, default_port, secure)) throw_scheme_registered(scheme);
+    }
+
+    // same as register_scheme(), but return false instead of throwing if scheme is already registered
+    static bool try_register_scheme (const string& scheme, const std::type_info*, uricreator, urimover, uint16_t default_port, bool secure = false);
+
+    template <class T>
+    static bool try_register_scheme (const string& scheme, uint16_t default_port, bool secure = false) {
+        return try_register_scheme(
+            scheme, &typeid(T),
+            [](const URI& u)->URI*{ return new T(u); },
+            [](URI&& u)->URI*{ return new T(std::move(u)); },
+            default_port, secure
+        );
+    }
+
+    // small integer id of a type registered by register_scheme(), assigned at first registration, -1 if type is not registered;
+    // schemes registered with the same type share the id, schemes registered with null type_info get -1
+    static int type_id (const std::type_info&);
+
+    template <class T>
+    static int type_id () {
+        static std::atomic<int> cached(-1); // ids never change once assigned, so caching found id is enough
+        int id = cached.load(std::memory_order_relaxed);
+        if (id < 0 && (id = type_id(typeid(T))) >= 0) cached.store(id, std::memory_order_relaxed);
+        return id;
+    }
 
     static URISP create (const string& source, int flags = 0) {
-        URI temp(source, flags);
-        if (temp.scheme_info) return temp.scheme_info->creator(temp);
-        else                  return new URI(temp);
+        return create(URI(source, flags));
     }
 
     static URISP create (const URI& source) {
@@ -61,12 +111,35 @@ struct URI : Refcnt {
         else                    return new URI(source);
     }
 
+    static URISP create (URI&& source) {
+        auto si = source.scheme_info;
+        if (!si)       return new URI(std::move(source));
+        if (si->mover) return si->mover(std::move(source));
+        return si->creator(source);
+    }
+
+    // returns NULL and fills err if source is invalid, while create() returns an empty URI
+    static URISP try_create (const string& source, ParseError& err, int flags = 0) {
+        URI temp;
+        if (!temp.try_assign(source, err, flags)) return nullptr;
+        return create(std::move(temp));
+    }
+
+    // returns URI parsed from source, or an empty URI and fills err if source is invalid
+    static URI try_parse (const string& source, ParseError& err, int flags = 0) {
+        URI ret;
+        ret.try_assign(source, err, flags);
+        return ret;
+    }
+
     URI ()                                               : scheme_info(NULL), _port(0), _qrev(1), _flags(0)     {}
     URI (const string& s, int flags = 0)                 : scheme_info(NULL), _port(0), _qrev(1), _flags(flags) { parse(s); }
     URI (const string& s, const Query& q, int flags = 0) : URI(s, flags)                                        { add_query(q); }
     URI (const URI& s)                                                                                          { assign(s); }
+    URI (URI&& s) noexcept                               : scheme_info(NULL), _port(0), _qrev(1), _flags(0)     { move_from(s); }
 
     URI& operator= (const URI& source)    { if (this != &source) assign(source); return *this; }
+    URI& operator= (URI&& source)         { if (this != &source) assign(std::move(source)); return *this; }
     URI& operator= (const string& source) { assign(source); return *this; }
 
     const string& scheme        () const { return _scheme; }
@@ -94,6 +167,15 @@ struct URI : Refcnt {
         _fragment   = source._fragment;
         _port       = source._port;
         _flags      = source._flags;
+        _str        = source._str;
+        _str_port   = source._str_port;
+        _str_path   = source._str_path;
+        _str_frag   = source._str_frag;
+    }
+
+    // not noexcept: Strict types override it to throw WrongScheme
+    virtual void assign (URI&& source) {
+        if (this != &source) move_from(source);
     }
 
     void assign (const string& s, int flags = 0) {
@@ -102,6 +184,19 @@ struct URI : Refcnt {
         parse(s);
     }
 
+    // same as assign(), but returns false instead of throwing, leaving URI empty. Strict types also fail on wrong scheme
+    virtual bool try_assign (const string& s, ParseError& err, int flags = 0) {
+        clear();
+        _flags = flags;
+        err = URI::parse(s, nullptr);
+        return !err;
+    }
+
+    bool try_assign (const string& s, int flags = 0) {
+        ParseError err;
+        return try_assign(s, err, flags);
+    }
+
     const string& query_string () const {
         sync_query_string();
         return _qstr;
@@ -125,14 +220,20 @@ struct URI : Refcnt {
     virtual void scheme (const string& scheme) {
         _scheme = scheme;
         sync_scheme_info();
+        invalidate();
     }
 
-    void user_info (const string& user_info) { _user_info = user_info; }
-    void host      (const string& host)      { _host      = host; }
-    void fragment  (const string& fragment)  { _fragment  = fragment; }
-    void port      (uint16_t port)           { _port      = port; }
+    void user_info (const string& user_info) { _user_info = user_info;            invalidate(); }
+    void user_info (string&& user_info)      { _user_info = std::move(user_info); invalidate(); }
+    void host      (const string& host)      { _host      = host;                 invalidate(); }
+    void host      (string&& host)           { _host      = std::move(host);      invalidate(); }
+
+    void fragment (const string& fragment) { _fragment = fragment;            sync_fragment(); }
+    void fragment (string&& fragment)      { _fragment = std::move(fragment); sync_fragment(); }
+    void port     (uint16_t port);
 
     void path (const string& path) {
+        invalidate();
         if (path && path.front() != '/') {
             _path = '/';
             _path += path;
@@ -140,22 +241,41 @@ struct URI : Refcnt {
         else _path = path;
     }
 
+    void path (string&& path) {
+        if (path && path.front() != '/') return this->path(static_cast<const string&>(path));
+        invalidate();
+        _path = std::move(path);
+    }
+
     void query_string (const string& qstr) {
         _qstr = qstr;
         ok_qstr();
+        invalidate();
+    }
+
+    void query_string (string&& qstr) {
+        _qstr = std::move(qstr);
+        ok_qstr();
+        invalidate();
     }
 
     void raw_query (const string& rq) {
         _qstr.clear();
         encode_uri_component(rq, _qstr, URIComponent::query);
         ok_qstr();
+        invalidate();
     }
 
     void query (const string& qstr) { query_string(qstr); }
+    void query (string&& qstr)      { query_string(std::move(qstr)); }
     void query (const Query& query) {
         _query = query;
         ok_query();
     }
+    void query (Query&& query) {
+        _query = std::move(query);
+        ok_query();
+    }
 
     void add_query (const string& qstr);
     void add_query (const Query& query);
@@ -205,6 +325,7 @@ struct URI : Refcnt {
     }
 
     void location (const string& newloc) {
+        invalidate();
         if (!newloc) {
             _host.clear();
             _port = 0;
@@ -228,6 +349,7 @@ struct URI : Refcnt {
 
     template <class It>
     void path_segments (It begin, It end) {
+        invalidate();
         _path.clear();
         for (auto it = begin; it != end; ++it) {
             if (!it->length()) continue;
@@ -238,9 +360,20 @@ struct URI : Refcnt {
 
     void path_segments (std::initializer_list<string_view> l) { path_segments(l.begin(), l.end()); }
 
+    // builds and caches the string on first call. Like query() and query_string() it writes lazy caches and returns refcounted
+    // copies, so const methods of one URI object must not be called concurrently from several threads without synchronization
     string to_string (bool relative = false) const;
     string relative  () const { return to_string(true); }
 
+    size_t serialized_length (bool relative = false) const;                 // exact length of to_string(relative)
+    char*  serialize_to      (char* dest, bool relative = false) const;     // writes exactly serialized_length(relative) bytes, returns end pointer
+    void   append_to         (string& dest, bool relative = false) const;
+
+    // fills up to max_slices slices pointing into uri components (or into cached to_string() result), without copying
+    // them; parts that need encoding (and port digits) are written to buf. Neither buf nor the URI may be modified while
+    // slices are in use, as any change may free the memory they point to. returns slice count
+    size_t serialize_slices (Slice* dest, string& buf, bool relative = false) const;
+
     bool equals (const URI& uri) const {
         if (_path != uri._path || _host != uri._host || _user_info != uri._user_info || _fragment != uri._fragment || _scheme != uri._scheme) return false;
         if (_port != uri._port && port() != uri.port()) return false;
@@ -264,9 +397,39 @@ protected:
 
     virtual void parse (const string&);
 
-    static SchemeInfo* get_scheme_info (const std::type_info*);
+    // parser calls filter as soon as scheme is read and stops if it returns false: URI is cleared except for the
+    // rejected scheme and wrong_scheme error is returned; invalid input clears URI like parse() does
+    ParseError parse (const string&, schemefilter filter);
+
+    [[noreturn]] static void throw_scheme_registered (const string& scheme);
+
+    static SchemeInfo* get_scheme_info  (const std::type_info*);
+    static SchemeInfo* find_scheme_info (const string& scheme); // case-insensitive, NULL if not registered
+
+    // steals strings and query tree, source is left empty
+    void move_from (URI& source) noexcept {
+        _scheme     = std::move(source._scheme);
+        scheme_info = source.scheme_info;
+        _user_info  = std::move(source._user_info);
+        _host       = std::move(source._host);
+        _path       = std::move(source._path);
+        _qstr       = std::move(source._qstr);
+        _query      = std::move(source._query);
+        _query.rev  = source._query.rev;
+        _qrev       = source._qrev;
+        _fragment   = std::move(source._fragment);
+        _port       = source._port;
+        _flags      = source._flags;
+        _str        = std::move(source._str);
+        _str_port   = source._str_port;
+        _str_path   = source._str_path;
+        _str_frag   = source._str_frag;
+        source.clear();
+    }
 
 private:
+    friend struct QueryWriter;
+
     string           _scheme;
     string           _user_info;
     string           _host;
@@ -277,9 +440,15 @@ private:
     mutable Query    _query;
     mutable uint32_t _qrev; // last query rev we've synced query string with (0 if query itself isn't synced with string)
     int              _flags;
+    mutable string   _str;      // cached to_string() result, empty when invalidated
+    mutable size_t   _str_port = 0; // offsets in _str where ":port", path and "#fragment" parts start (valid while _str is non-empty)
+    mutable size_t   _str_path = 0;
+    mutable size_t   _str_frag = 0;
 
     static const string _empty;
 
+    void invalidate () const { _str.clear(); }
+
     void ok_qstr      () const { _qrev = 0; }
     void ok_query     () const { _qrev = _query.rev - 1; }
     void ok_qboth     () const { _qrev = _query.rev; }
@@ -298,9 +467,18 @@ private:
         _fragment.clear();
         ok_qboth();
         _flags = 0;
+        invalidate();
     }
 
     void guess_suffix_reference ();
+    void sync_fragment          (); // updates cached string after fragment change
+
+    size_t prefix_length () const;
+    size_t port_length   () const;
+    char*  write_prefix  (char*) const;
+    char*  write_port    (char*) const;
+    char*  write_tail    (char*, bool relative) const;
+    void   build_str     () const;
 
     void compile_query () const;
     void parse_query   () const;
@@ -310,14 +488,21 @@ private:
 
     void sync_scheme_info ();
 
-    static inline void _encode_uri_component_append (const string_view& src, string& dest, const char* unsafe) {
-        char* buf = dest.reserve(dest.length() + src.length()*3) + dest.length();
-        size_t final_size = encode_uri_component(src, buf, unsafe);
+    static inline void _encode_uri_component_append (const string_view& src, string& dest, const Alphabet& component) {
+        char* buf = dest.reserve(dest.length() + encoded_length(src, component)) + dest.length();
+        size_t final_size = encode_uri_component(src, buf, component);
         dest.length(dest.length() + final_size);
     }
 
-    bool _parse     (const string&, bool&);
-    bool _parse_ext (const string&, bool&);
+    struct ParseContext {
+        schemefilter filter;
+        bool         authority_has_pct;
+        bool         scheme_rejected;
+        size_t       position; // where the machine stopped
+    };
+
+    bool _parse     (const string&, ParseContext&);
+    bool _parse_ext (const string&, ParseContext&);
 };
 
 std::ostream& operator<< (std::ostream& os, const URI& uri);
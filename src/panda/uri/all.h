@@ -5,3 +5,6 @@
 #include <panda/uri/http.h>
 #include <panda/uri/socks.h>
 #include <panda/uri/telnet.h>
+#include <panda/uri/FormParser.h>
+#include <panda/uri/QueryWriter.h>
+#include <panda/uri/stats.h>
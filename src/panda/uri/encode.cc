@@ -1,45 +1,713 @@
 #include <panda/uri/encode.h>
+#include <atomic>
 #include <climits>
+#include <cstring>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define PANDA_URI_X86_KERNELS
+    #include <immintrin.h>
+#endif
 
 namespace panda { namespace uri {
 
-#include "encode_gen.icc"
+constexpr Alphabet URIComponent::scheme;
+constexpr Alphabet URIComponent::user_info;
+constexpr Alphabet URIComponent::host;
+constexpr Alphabet URIComponent::path;
+constexpr Alphabet URIComponent::path_segment;
+constexpr Alphabet URIComponent::query;
+constexpr Alphabet URIComponent::query_param;
+constexpr Alphabet URIComponent::query_param_plus;
+constexpr Alphabet URIComponent::fragment;
+constexpr Alphabet URIComponent::whatwg_path;
+constexpr Alphabet URIComponent::whatwg_userinfo;
+constexpr Alphabet URIComponent::form_urlencoded;
+constexpr Alphabet URIComponent::oauth;
 
 typedef unsigned char uchar;
 
-size_t encode_uri_component (const string_view src, char* dest, const char* unsafe) {
-    const char* str = src.data();
-    const char*const end = str + src.length();
-    char* buf = dest;
+static inline char hex_digit (uchar n) { return n < 10 ? '0' + n : 'A' - 10 + n; }
+
+static inline bool is_replaced (uchar c, const Alphabet& a) { return c == ' ' && a.space; }
+
+static inline char* encode_char (char* buf, uchar c, const Alphabet& a) {
+    if (a.contains(c)) *buf++ = c;
+    else if (is_replaced(c, a)) *buf++ = a.space;
+    else {
+        *buf++ = '%';
+        *buf++ = hex_digit(c >> 4);
+        *buf++ = hex_digit(c & 15);
+    }
+    return buf;
+}
+
+static char* encode_scalar (const char* str, const char* end, char* buf, const Alphabet& a) {
+    while (str != end) buf = encode_char(buf, *str++, a);
+    return buf;
+}
+
+static inline uchar unhex (uchar c) {
+    uchar digit = c - '0';
+    if (digit < 10) return digit;
+    uchar letter = (c | 0x20) - 'a';
+    if (letter < 6) return letter + 10;
+    return 0;
+}
+
+// decodes escape sequence or '+' at *str, advancing str. '\0' is treated as escape start like '%' for compatibility
+// with former table-driven decoder. Incomplete escape at the end of input is dropped.
+static inline char* decode_special (const char*& str, const char* end, char* buf) {
+    uchar c = *str++;
+    if (c == '+') *buf++ = ' ';
+    else if (str < end-1) {
+        *buf++ = (unhex(str[0]) << 4) | unhex(str[1]);
+        str += 2;
+    }
+    return buf;
+}
+
+static inline bool is_special (uchar c) { return c == '%' || c == '+' || c == 0; }
 
+static char* decode_scalar (const char* str, const char* end, char* buf) {
     while (str != end) {
-        uchar uc = *str++;
-        if (unsafe[uc] != 0) *buf++ = unsafe[uc];
-        else {
-            *buf++ = '%';
-            *buf++ = _forward[uc][0];
-            *buf++ = _forward[uc][1];
+        if (is_special(*str)) buf = decode_special(str, end, buf);
+        else *buf++ = *str++;
+    }
+    return buf;
+}
+
+static const char* find_unsafe_scalar (const char* str, const char* end, const Alphabet& a) {
+    while (str != end && a.contains(*str)) ++str;
+    return str;
+}
+
+static const char* find_special_scalar (const char* str, const char* end) {
+    while (str != end && !is_special(*str)) ++str;
+    return str;
+}
+
+static size_t count_encoded_scalar (const char* str, const char* end, const Alphabet& a) {
+    size_t cnt = 0;
+    for (; str != end; ++str) cnt += !a.contains(*str) && !is_replaced(*str, a);
+    return cnt;
+}
+
+static size_t encoded_length_scalar (const char* str, const char* end, const Alphabet& a) {
+    return (end - str) + 2 * count_encoded_scalar(str, end, a);
+}
+
+#ifdef PANDA_URI_X86_KERNELS
+
+// Vector kernels classify input with alphabet bitset halves as pshufb tables: row for byte C is looked up in the
+// first half by (C & 0x8F) and in the second half by ((C ^ 0x80) & 0x8F), pshufb yields zero for the half that
+// doesn't match C's top bit; then the row is tested against bit (C >> 4) & 7.
+// Each *_blocks() function processes whole blocks only and leaves str pointing to the unprocessed tail.
+
+#define SSE42_FUNC  __attribute__((target("sse4.2,popcnt")))
+#define AVX2_FUNC   __attribute__((target("avx2,popcnt")))
+#define AVX512_FUNC __attribute__((target("avx512f,avx512bw,popcnt")))
+
+static const uint8_t _rowbits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+
+// alphabet with ' ' added if it's replaced: bytes that are not turned into %XX
+static inline Alphabet kept_bytes (const Alphabet& a) {
+    Alphabet ret = a;
+    if (a.space) ret.bits[' ' & 15] |= 1 << (' ' >> 4);
+    return ret;
+}
+
+// bitmasks of bytes not in alphabet
+SSE42_FUNC static inline unsigned outside_sse42 (__m128i v, __m128i lotbl, __m128i hitbl) {
+    const __m128i idx  = _mm_set1_epi8((char)0x8f);
+    const __m128i top  = _mm_set1_epi8((char)0x80);
+    const __m128i bits = _mm_loadu_si128((const __m128i*)_rowbits);
+    __m128i row = _mm_or_si128(_mm_shuffle_epi8(lotbl, _mm_and_si128(v, idx)), _mm_shuffle_epi8(hitbl, _mm_and_si128(_mm_xor_si128(v, top), idx)));
+    __m128i bit = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128()));
+}
+
+AVX2_FUNC static inline unsigned outside_avx2 (__m256i v, __m256i lotbl, __m256i hitbl) {
+    const __m256i idx  = _mm256_set1_epi8((char)0x8f);
+    const __m256i top  = _mm256_set1_epi8((char)0x80);
+    const __m256i bits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)_rowbits));
+    __m256i row = _mm256_or_si256(_mm256_shuffle_epi8(lotbl, _mm256_and_si256(v, idx)), _mm256_shuffle_epi8(hitbl, _mm256_and_si256(_mm256_xor_si256(v, top), idx)));
+    __m256i bit = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f)));
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256()));
+}
+
+// maskz form avoids gcc's false "uninitialized" warning about _mm512_undefined_epi32() inside _mm512_broadcast_i32x4()
+AVX512_FUNC static inline __m512i broadcast_avx512 (__m128i v) { return _mm512_maskz_broadcast_i32x4(0xFFFF, v); }
+
+// masked loads/stores let AVX-512 kernels handle the tail shorter than a block (or a whole short string) in one step
+AVX512_FUNC static inline uint64_t tail_mask (const char* str, const char* end) { return (1ULL << (end - str)) - 1; }
+
+AVX512_FUNC static inline uint64_t outside_avx512 (__m512i v, __m512i lotbl, __m512i hitbl) {
+    const __m512i idx  = _mm512_set1_epi8((char)0x8f);
+    const __m512i top  = _mm512_set1_epi8((char)0x80);
+    const __m512i bits = broadcast_avx512(_mm_loadu_si128((const __m128i*)_rowbits));
+    __m512i row = _mm512_or_si512(_mm512_shuffle_epi8(lotbl, _mm512_and_si512(v, idx)), _mm512_shuffle_epi8(hitbl, _mm512_and_si512(_mm512_xor_si512(v, top), idx)));
+    __m512i bit = _mm512_shuffle_epi8(bits, _mm512_and_si512(_mm512_srli_epi16(v, 4), _mm512_set1_epi8(0x0f)));
+    return _mm512_testn_epi8_mask(row, bit);
+}
+
+#define SSE42_TABLES(a)                                                  \
+    const __m128i lotbl = _mm_loadu_si128((const __m128i*)(a).bits);      \
+    const __m128i hitbl = _mm_loadu_si128((const __m128i*)((a).bits + 16))
+
+#define AVX2_TABLES(a)                                                                         \
+    const __m256i lotbl = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(a).bits)); \
+    const __m256i hitbl = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)((a).bits + 16)))
+
+#define AVX512_TABLES(a)                                                                  \
+    const __m512i lotbl = broadcast_avx512(_mm_loadu_si128((const __m128i*)(a).bits)); \
+    const __m512i hitbl = broadcast_avx512(_mm_loadu_si128((const __m128i*)((a).bits + 16)))
+
+SSE42_FUNC static char* encode_sse42_blocks (const char*& str, const char* end, char* buf, const Alphabet& a) {
+    SSE42_TABLES(a);
+    while (end - str >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)str);
+        unsigned mask = outside_sse42(v, lotbl, hitbl);
+        if (!mask) {
+            _mm_storeu_si128((__m128i*)buf, v);
+            str += 16;
+            buf += 16;
+            continue;
         }
+        unsigned safe_len = __builtin_ctz(mask);
+        memcpy(buf, str, safe_len);
+        buf += safe_len;
+        buf = encode_scalar(str + safe_len, str + 16, buf, a);
+        str += 16;
     }
+    return buf;
+}
 
-    return buf - dest;
+AVX2_FUNC static char* encode_avx2_blocks (const char*& str, const char* end, char* buf, const Alphabet& a) {
+    AVX2_TABLES(a);
+    while (end - str >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)str);
+        unsigned mask = outside_avx2(v, lotbl, hitbl);
+        if (!mask) {
+            _mm256_storeu_si256((__m256i*)buf, v);
+            str += 32;
+            buf += 32;
+            continue;
+        }
+        unsigned safe_len = __builtin_ctz(mask);
+        memcpy(buf, str, safe_len);
+        buf += safe_len;
+        buf = encode_scalar(str + safe_len, str + 32, buf, a);
+        str += 32;
+    }
+    return buf;
+}
+
+AVX512_FUNC static char* encode_avx512_blocks (const char*& str, const char* end, char* buf, const Alphabet& a) {
+    AVX512_TABLES(a);
+    while (end - str >= 64) {
+        __m512i v = _mm512_loadu_si512((const void*)str);
+        uint64_t mask = outside_avx512(v, lotbl, hitbl);
+        if (!mask) {
+            _mm512_storeu_si512((void*)buf, v);
+            str += 64;
+            buf += 64;
+            continue;
+        }
+        unsigned safe_len = __builtin_ctzll(mask);
+        memcpy(buf, str, safe_len);
+        buf += safe_len;
+        buf = encode_scalar(str + safe_len, str + 64, buf, a);
+        str += 64;
+    }
+    return buf;
+}
+
+SSE42_FUNC static char* encode_sse42 (const char* str, const char* end, char* buf, const Alphabet& a) {
+    buf = encode_sse42_blocks(str, end, buf, a);
+    return encode_scalar(str, end, buf, a);
+}
+
+AVX2_FUNC static char* encode_avx2 (const char* str, const char* end, char* buf, const Alphabet& a) {
+    buf = encode_avx2_blocks(str, end, buf, a);
+    buf = encode_sse42_blocks(str, end, buf, a);
+    return encode_scalar(str, end, buf, a);
+}
+
+// copies the tail if nothing in it needs encoding
+AVX512_FUNC static bool copy_safe_tail_avx512 (const char* str, const char* end, char* buf, const Alphabet& a) {
+    AVX512_TABLES(a);
+    uint64_t m = tail_mask(str, end);
+    __m512i  v = _mm512_maskz_loadu_epi8(m, str);
+    if (outside_avx512(v, lotbl, hitbl) & m) return false;
+    _mm512_mask_storeu_epi8(buf, m, v);
+    return true;
+}
+
+AVX512_FUNC static char* encode_avx512 (const char* str, const char* end, char* buf, const Alphabet& a) {
+    buf = encode_avx512_blocks(str, end, buf, a);
+    if (copy_safe_tail_avx512(str, end, buf, a)) return buf + (end - str);
+    buf = encode_avx2_blocks(str, end, buf, a);
+    buf = encode_sse42_blocks(str, end, buf, a);
+    return encode_scalar(str, end, buf, a);
+}
+
+SSE42_FUNC static char* decode_sse42_blocks (const char*& str, const char* end, char* buf) {
+    const __m128i pct  = _mm_set1_epi8('%');
+    const __m128i plus = _mm_set1_epi8('+');
+    const __m128i zero = _mm_setzero_si128();
+
+    while (end - str >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)str);
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, pct), _mm_cmpeq_epi8(v, plus)), _mm_cmpeq_epi8(v, zero));
+        unsigned mask = _mm_movemask_epi8(special);
+        if (!mask) {
+            _mm_storeu_si128((__m128i*)buf, v);
+            str += 16;
+            buf += 16;
+            continue;
+        }
+        unsigned clean_len = __builtin_ctz(mask);
+        memmove(buf, str, clean_len); // dest may overlap src when decoding in place
+        buf += clean_len;
+        str += clean_len;
+        buf = decode_special(str, end, buf);
+    }
+    return buf;
+}
+
+AVX2_FUNC static char* decode_avx2_blocks (const char*& str, const char* end, char* buf) {
+    const __m256i pct  = _mm256_set1_epi8('%');
+    const __m256i plus = _mm256_set1_epi8('+');
+    const __m256i zero = _mm256_setzero_si256();
+
+    while (end - str >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)str);
+        __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, pct), _mm256_cmpeq_epi8(v, plus)), _mm256_cmpeq_epi8(v, zero));
+        unsigned mask = _mm256_movemask_epi8(special);
+        if (!mask) {
+            _mm256_storeu_si256((__m256i*)buf, v);
+            str += 32;
+            buf += 32;
+            continue;
+        }
+        unsigned clean_len = __builtin_ctz(mask);
+        memmove(buf, str, clean_len); // dest may overlap src when decoding in place
+        buf += clean_len;
+        str += clean_len;
+        buf = decode_special(str, end, buf);
+    }
+    return buf;
+}
+
+AVX512_FUNC static inline uint64_t special_avx512 (__m512i v) {
+    return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('%')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('+')) | _mm512_testn_epi8_mask(v, v);
+}
+
+AVX512_FUNC static char* decode_avx512_blocks (const char*& str, const char* end, char* buf) {
+    while (end - str >= 64) {
+        __m512i v = _mm512_loadu_si512((const void*)str);
+        uint64_t mask = special_avx512(v);
+        if (!mask) {
+            _mm512_storeu_si512((void*)buf, v);
+            str += 64;
+            buf += 64;
+            continue;
+        }
+        unsigned clean_len = __builtin_ctzll(mask);
+        memmove(buf, str, clean_len); // dest may overlap src when decoding in place
+        buf += clean_len;
+        str += clean_len;
+        buf = decode_special(str, end, buf);
+    }
+    return buf;
+}
+
+SSE42_FUNC static char* decode_sse42 (const char* str, const char* end, char* buf) {
+    buf = decode_sse42_blocks(str, end, buf);
+    return decode_scalar(str, end, buf);
+}
+
+AVX2_FUNC static char* decode_avx2 (const char* str, const char* end, char* buf) {
+    buf = decode_avx2_blocks(str, end, buf);
+    buf = decode_sse42_blocks(str, end, buf);
+    return decode_scalar(str, end, buf);
+}
+
+// copies the tail if nothing in it needs decoding
+AVX512_FUNC static bool copy_clean_tail_avx512 (const char* str, const char* end, char* buf) {
+    uint64_t m = tail_mask(str, end);
+    __m512i  v = _mm512_maskz_loadu_epi8(m, str);
+    if (special_avx512(v) & m) return false;
+    _mm512_mask_storeu_epi8(buf, m, v);
+    return true;
+}
+
+AVX512_FUNC static char* decode_avx512 (const char* str, const char* end, char* buf) {
+    buf = decode_avx512_blocks(str, end, buf);
+    if (copy_clean_tail_avx512(str, end, buf)) return buf + (end - str);
+    buf = decode_avx2_blocks(str, end, buf);
+    buf = decode_sse42_blocks(str, end, buf);
+    return decode_scalar(str, end, buf);
+}
+
+// *_scan_blocks() functions return true and leave str pointing to the found byte, or return false leaving str at the tail
+
+SSE42_FUNC static bool find_unsafe_sse42_blocks (const char*& str, const char* end, const Alphabet& a) {
+    SSE42_TABLES(a);
+    for (; end - str >= 16; str += 16) {
+        unsigned mask = outside_sse42(_mm_loadu_si128((const __m128i*)str), lotbl, hitbl);
+        if (mask) {
+            str += __builtin_ctz(mask);
+            return true;
+        }
+    }
+    return false;
+}
+
+AVX2_FUNC static bool find_unsafe_avx2_blocks (const char*& str, const char* end, const Alphabet& a) {
+    AVX2_TABLES(a);
+    for (; end - str >= 32; str += 32) {
+        unsigned mask = outside_avx2(_mm256_loadu_si256((const __m256i*)str), lotbl, hitbl);
+        if (mask) {
+            str += __builtin_ctz(mask);
+            return true;
+        }
+    }
+    return false;
+}
+
+AVX512_FUNC static bool find_unsafe_avx512_blocks (const char*& str, const char* end, const Alphabet& a) {
+    AVX512_TABLES(a);
+    for (; end - str >= 64; str += 64) {
+        uint64_t mask = outside_avx512(_mm512_loadu_si512((const void*)str), lotbl, hitbl);
+        if (mask) {
+            str += __builtin_ctzll(mask);
+            return true;
+        }
+    }
+    return false;
+}
+
+SSE42_FUNC static const char* find_unsafe_sse42 (const char* str, const char* end, const Alphabet& a) {
+    if (find_unsafe_sse42_blocks(str, end, a)) return str;
+    return find_unsafe_scalar(str, end, a);
+}
+
+AVX2_FUNC static const char* find_unsafe_avx2 (const char* str, const char* end, const Alphabet& a) {
+    if (find_unsafe_avx2_blocks(str, end, a) || find_unsafe_sse42_blocks(str, end, a)) return str;
+    return find_unsafe_scalar(str, end, a);
+}
+
+AVX512_FUNC static const char* find_unsafe_avx512 (const char* str, const char* end, const Alphabet& a) {
+    if (find_unsafe_avx512_blocks(str, end, a)) return str;
+    AVX512_TABLES(a);
+    uint64_t mask = outside_avx512(_mm512_maskz_loadu_epi8(tail_mask(str, end), str), lotbl, hitbl) & tail_mask(str, end);
+    return mask ? str + __builtin_ctzll(mask) : end;
+}
+
+SSE42_FUNC static bool find_special_sse42_blocks (const char*& str, const char* end) {
+    const __m128i pct  = _mm_set1_epi8('%');
+    const __m128i plus = _mm_set1_epi8('+');
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; end - str >= 16; str += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)str);
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, pct), _mm_cmpeq_epi8(v, plus)), _mm_cmpeq_epi8(v, zero));
+        unsigned mask = _mm_movemask_epi8(special);
+        if (mask) {
+            str += __builtin_ctz(mask);
+            return true;
+        }
+    }
+    return false;
+}
+
+AVX2_FUNC static bool find_special_avx2_blocks (const char*& str, const char* end) {
+    const __m256i pct  = _mm256_set1_epi8('%');
+    const __m256i plus = _mm256_set1_epi8('+');
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (; end - str >= 32; str += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)str);
+        __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, pct), _mm256_cmpeq_epi8(v, plus)), _mm256_cmpeq_epi8(v, zero));
+        unsigned mask = _mm256_movemask_epi8(special);
+        if (mask) {
+            str += __builtin_ctz(mask);
+            return true;
+        }
+    }
+    return false;
+}
+
+AVX512_FUNC static bool find_special_avx512_blocks (const char*& str, const char* end) {
+    for (; end - str >= 64; str += 64) {
+        uint64_t mask = special_avx512(_mm512_loadu_si512((const void*)str));
+        if (mask) {
+            str += __builtin_ctzll(mask);
+            return true;
+        }
+    }
+    return false;
+}
+
+SSE42_FUNC static const char* find_special_sse42 (const char* str, const char* end) {
+    if (find_special_sse42_blocks(str, end)) return str;
+    return find_special_scalar(str, end);
+}
+
+AVX2_FUNC static const char* find_special_avx2 (const char* str, const char* end) {
+    if (find_special_avx2_blocks(str, end) || find_special_sse42_blocks(str, end)) return str;
+    return find_special_scalar(str, end);
+}
+
+AVX512_FUNC static const char* find_special_avx512 (const char* str, const char* end) {
+    if (find_special_avx512_blocks(str, end)) return str;
+    uint64_t mask = special_avx512(_mm512_maskz_loadu_epi8(tail_mask(str, end), str)) & tail_mask(str, end);
+    return mask ? str + __builtin_ctzll(mask) : end;
+}
+
+// count_encoded_*_blocks() count bytes outside of 'keep' (i.e. turned into %XX) in whole blocks, leaving str at the tail
+
+SSE42_FUNC static size_t count_encoded_sse42_blocks (const char*& str, const char* end, const Alphabet& keep) {
+    SSE42_TABLES(keep);
+    size_t cnt = 0;
+    for (; end - str >= 16; str += 16) cnt += __builtin_popcount(outside_sse42(_mm_loadu_si128((const __m128i*)str), lotbl, hitbl));
+    return cnt;
+}
+
+AVX2_FUNC static size_t count_encoded_avx2_blocks (const char*& str, const char* end, const Alphabet& keep) {
+    AVX2_TABLES(keep);
+    size_t cnt = 0;
+    for (; end - str >= 32; str += 32) cnt += __builtin_popcount(outside_avx2(_mm256_loadu_si256((const __m256i*)str), lotbl, hitbl));
+    return cnt;
+}
+
+AVX512_FUNC static size_t count_encoded_avx512_blocks (const char*& str, const char* end, const Alphabet& keep) {
+    AVX512_TABLES(keep);
+    size_t cnt = 0;
+    for (; end - str >= 64; str += 64) cnt += __builtin_popcountll(outside_avx512(_mm512_loadu_si512((const void*)str), lotbl, hitbl));
+    return cnt;
+}
+
+SSE42_FUNC static size_t encoded_length_sse42 (const char* str, const char* end, const Alphabet& a) {
+    size_t len = end - str;
+    size_t cnt = count_encoded_sse42_blocks(str, end, kept_bytes(a));
+    return len + 2 * (cnt + count_encoded_scalar(str, end, a));
+}
+
+AVX2_FUNC static size_t encoded_length_avx2 (const char* str, const char* end, const Alphabet& a) {
+    size_t len = end - str;
+    auto keep = kept_bytes(a);
+    size_t cnt = count_encoded_avx2_blocks(str, end, keep);
+    cnt += count_encoded_sse42_blocks(str, end, keep);
+    return len + 2 * (cnt + count_encoded_scalar(str, end, a));
+}
+
+AVX512_FUNC static size_t encoded_length_avx512 (const char* str, const char* end, const Alphabet& a) {
+    size_t len = end - str;
+    auto keep = kept_bytes(a);
+    size_t cnt = count_encoded_avx512_blocks(str, end, keep);
+    AVX512_TABLES(keep);
+    cnt += __builtin_popcountll(outside_avx512(_mm512_maskz_loadu_epi8(tail_mask(str, end), str), lotbl, hitbl) & tail_mask(str, end));
+    return len + 2 * cnt;
+}
+
+#endif // PANDA_URI_X86_KERNELS
+
+// ============== runtime dispatch ===================
+// Kernels are bound on first use (normally during static initialization), like ifunc resolvers do.
+
+struct Kernels {
+    char*       (*encode)       (const char*, const char*, char*, const Alphabet&);
+    char*       (*decode)       (const char*, const char*, char*);
+    const char* (*find_unsafe)  (const char*, const char*, const Alphabet&);
+    const char* (*find_special) (const char*, const char*);
+    size_t      (*length)       (const char*, const char*, const Alphabet&);
+};
+
+static const Kernels _scalar_kernels = {encode_scalar, decode_scalar, find_unsafe_scalar, find_special_scalar, encoded_length_scalar};
+#ifdef PANDA_URI_X86_KERNELS
+static const Kernels _sse42_kernels  = {encode_sse42,  decode_sse42,  find_unsafe_sse42,  find_special_sse42,  encoded_length_sse42};
+static const Kernels _avx2_kernels   = {encode_avx2,   decode_avx2,   find_unsafe_avx2,   find_special_avx2,   encoded_length_avx2};
+static const Kernels _avx512_kernels = {encode_avx512, decode_avx512, find_unsafe_avx512, find_special_avx512, encoded_length_avx512};
+#endif
+
+static SimdLevel detect_simd_level () {
+#ifdef PANDA_URI_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) return SimdLevel::avx512;
+    if (__builtin_cpu_supports("avx2"))     return SimdLevel::avx2;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) return SimdLevel::sse42;
+#endif
+    return SimdLevel::scalar;
+}
+
+static SimdLevel max_simd_level () {
+    static const SimdLevel ret = detect_simd_level();
+    return ret;
+}
+
+static const Kernels& resolve ();
+
+static char*       resolve_encode       (const char* str, const char* end, char* buf, const Alphabet& a) { return resolve().encode(str, end, buf, a); }
+static char*       resolve_decode       (const char* str, const char* end, char* buf)                    { return resolve().decode(str, end, buf); }
+static const char* resolve_find_unsafe  (const char* str, const char* end, const Alphabet& a)            { return resolve().find_unsafe(str, end, a); }
+static const char* resolve_find_special (const char* str, const char* end)                               { return resolve().find_special(str, end); }
+static size_t      resolve_length       (const char* str, const char* end, const Alphabet& a)            { return resolve().length(str, end, a); }
+
+static const Kernels  _resolver_kernels = {resolve_encode, resolve_decode, resolve_find_unsafe, resolve_find_special, resolve_length};
+// atomic, as simd_level(SimdLevel) may rebind them while other threads run the codec; kernel tables are constant,
+// so relaxed loads are enough
+static std::atomic<const Kernels*> _kernels(&_resolver_kernels);
+static std::atomic<SimdLevel>      _simd_level(SimdLevel::scalar);
+
+static inline const Kernels& kernels () { return *_kernels.load(std::memory_order_relaxed); }
+
+static const Kernels& bind_kernels (SimdLevel level) {
+    const Kernels* k = &_scalar_kernels;
+#ifdef PANDA_URI_X86_KERNELS
+    switch (level) {
+        case SimdLevel::avx512 : k = &_avx512_kernels; break;
+        case SimdLevel::avx2   : k = &_avx2_kernels;   break;
+        case SimdLevel::sse42  : k = &_sse42_kernels;  break;
+        case SimdLevel::scalar : break;
+    }
+#endif
+    _simd_level.store(level, std::memory_order_relaxed);
+    _kernels.store(k, std::memory_order_relaxed);
+    return *k;
+}
+
+static const Kernels& resolve () { return bind_kernels(max_simd_level()); }
+
+static const int __init = (resolve(), 0);
+
+SimdLevel simd_level () {
+    return _simd_level.load(std::memory_order_relaxed);
+}
+
+SimdLevel simd_level (SimdLevel level) {
+    if (level > max_simd_level()) level = max_simd_level();
+    bind_kernels(level);
+    return level;
+}
+
+const char* simd_level_name (SimdLevel level) {
+    switch (level) {
+        case SimdLevel::scalar : return "scalar";
+        case SimdLevel::sse42  : return "sse4.2";
+        case SimdLevel::avx2   : return "avx2";
+        case SimdLevel::avx512 : return "avx512";
+    }
+    return "unknown";
+}
+
+size_t encode_uri_component (const string_view src, char* dest, const Alphabet& a) {
+    return kernels().encode(src.data(), src.data() + src.length(), dest, a) - dest;
+}
+
+size_t encoded_length (const string_view src, const Alphabet& a) {
+    return kernels().length(src.data(), src.data() + src.length(), a);
 }
 
 size_t decode_uri_component (const string_view src, char* dest) {
-    const char* str = src.data();
-    const char*const end = str + src.length();
-    char* buf = dest;
+    return kernels().decode(src.data(), src.data() + src.length(), dest) - dest;
+}
 
-    while (str != end) {
-        char res = _restore[(uchar)*str++];
-        if (res != 0) *buf++ = res;
-        else if (str < end-1) {
-            *buf++ = _backward[(uchar)str[0]][0] | _backward[(uchar)str[1]][1];
-            str += 2;
+size_t find_first_unsafe (const string_view src, const Alphabet& a) {
+    const char* end = src.data() + src.length();
+    const char* pos = kernels().find_unsafe(src.data(), end, a);
+    return pos == end ? string::npos : pos - src.data();
+}
+
+size_t find_first_encoded (const string_view src) {
+    const char* end = src.data() + src.length();
+    const char* pos = kernels().find_special(src.data(), end);
+    return pos == end ? string::npos : pos - src.data();
+}
+
+void decode_uri_component_inplace (string& str) {
+    size_t pos = find_first_encoded(str);
+    if (pos == string::npos) return;
+
+    if (str.use_count() > 1) { // decode into new buffer rather than detach a copy and then decode it
+        string tmp;
+        decode_uri_component(str, tmp);
+        str = tmp;
+        return;
+    }
+
+    char* buf = str.buf();
+    str.length(pos + decode_uri_component(string_view(buf + pos, str.length() - pos), buf + pos));
+}
+
+void encode_uri_components (const string_view* src, size_t n, string& dest, size_t* offsets, const Alphabet& a) {
+    auto& k = kernels();
+    size_t total = dest.length();
+    for (size_t i = 0; i < n; ++i) total += k.length(src[i].data(), src[i].data() + src[i].length(), a);
+
+    char* begin = dest.reserve(total);
+    char* buf   = begin + dest.length();
+    for (size_t i = 0; i < n; ++i) {
+        offsets[i] = buf - begin;
+        buf = k.encode(src[i].data(), src[i].data() + src[i].length(), buf, a);
+    }
+    offsets[n] = buf - begin;
+    dest.length(buf - begin);
+}
+
+void decode_uri_components (const string_view* src, size_t n, string& dest, size_t* offsets) {
+    auto& k = kernels();
+    size_t total = dest.length();
+    for (size_t i = 0; i < n; ++i) total += src[i].length();
+
+    char* begin = dest.reserve(total);
+    char* buf   = begin + dest.length();
+    for (size_t i = 0; i < n; ++i) {
+        offsets[i] = buf - begin;
+        buf = k.decode(src[i].data(), src[i].data() + src[i].length(), buf);
+    }
+    offsets[n] = buf - begin;
+    dest.length(buf - begin);
+}
+
+static inline bool is_escape (uchar c) { return c == '%' || c == 0; }
+
+// position of escape sequence that is cut by the end of chunk or chunk.length() if there is none
+static size_t incomplete_escape_pos (const string_view chunk) {
+    size_t len = chunk.length();
+    // find escape boundary near the end: position is one if neither of two previous bytes can start an escape
+    size_t i = len > 2 ? len - 2 : 0;
+    while (i > 0 && (is_escape(chunk[i-1]) || (i > 1 && is_escape(chunk[i-2])))) --i;
+    while (i < len) i += is_escape(chunk[i]) ? 3 : 1;
+    return i > len ? i - 3 : len;
+}
+
+size_t StreamDecoder::decode (string_view chunk, char* dest) {
+    char* buf = dest;
+    if (_npending) {
+        while (_npending < 2 && chunk.length()) {
+            _pending[_npending++] = chunk[0];
+            chunk.remove_prefix(1);
         }
+        if (!chunk.length()) return 0;
+        *buf++ = (unhex(_pending[1]) << 4) | unhex(chunk[0]);
+        chunk.remove_prefix(1);
+        _npending = 0;
     }
 
+    size_t cut = incomplete_escape_pos(chunk);
+    buf += decode_uri_component(chunk.substr(0, cut), buf);
+    for (; cut < chunk.length(); ++cut) _pending[_npending++] = chunk[cut];
     return buf - dest;
 }
 
+size_t StreamDecoder::finish (char* dest) {
+    // one-shot decoder drops incomplete escape start and decodes what follows it as usual
+    size_t ret = _npending == 2 ? decode_scalar(_pending + 1, _pending + 2, dest) - dest : 0;
+    _npending = 0;
+    return ret;
+}
+
 }}
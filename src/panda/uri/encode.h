@@ -1,25 +1,116 @@
 #pragma once
+#include <cstdint>
+#include <type_traits>
 #include <panda/string.h>
 
 namespace panda { namespace uri {
 
+// Set of bytes that encoder passes through as is, all other bytes are encoded as %XX (except for ' ' if 'space' is set).
+// Bitset is nibble-transposed: byte C is in the set iff bits[(C >> 7) * 16 + (C & 15)] has bit ((C >> 4) & 7),
+// so that each half is a ready-made pshufb lookup table for vector kernels. '\0' is never in the set.
+// Custom alphabets are built at compile time with make_alphabet() and are as fast as built-in ones.
+struct Alphabet {
+    // character classes for make_alphabet()
+    enum : unsigned {
+        digit       = 1,
+        alpha       = 2,
+        sub_delims  = 4,  // !$&'()*+,;=
+        gen_delims  = 8,  // :/?#[]@
+        mark        = 16, // -._~
+        pchar_extra = 32, // :@
+        visible     = 64, // any printable ASCII char
+        reserved    = sub_delims | gen_delims,
+        unreserved  = alpha | digit | mark,
+        pchar       = unreserved | sub_delims | pchar_extra,
+    };
+
+    uint8_t bits[32];
+    char    space; // ' ' is replaced with this char instead of %20 if not 0
+
+    constexpr bool contains (unsigned char c) const { return bits[(c >> 7) * 16 + (c & 15)] & (1 << ((c >> 4) & 7)); }
+
+    constexpr Alphabet add (const char* chars) const {
+        Alphabet ret = *this;
+        while (*chars) ret.set(*chars++, true);
+        return ret;
+    }
+
+    constexpr Alphabet add (unsigned char first, unsigned char last) const {
+        Alphabet ret = *this;
+        for (unsigned c = first; c <= last; ++c) ret.set(c, true);
+        return ret;
+    }
+
+    constexpr Alphabet remove (const char* chars) const {
+        Alphabet ret = *this;
+        while (*chars) ret.set(*chars++, false);
+        return ret;
+    }
+
+    constexpr Alphabet space_as (char c) const {
+        Alphabet ret = *this;
+        ret.space = c;
+        return ret;
+    }
+
+private:
+    constexpr void set (unsigned char c, bool on) {
+        if (!c) return;
+        uint8_t& row = bits[(c >> 7) * 16 + (c & 15)];
+        uint8_t  bit = 1 << ((c >> 4) & 7);
+        row = on ? (row | bit) : (row & ~bit);
+    }
+};
+
+constexpr Alphabet make_alphabet (unsigned flags, const char* extra = "") {
+    Alphabet ret {};
+    if (flags & Alphabet::digit)       ret = ret.add('0', '9');
+    if (flags & Alphabet::alpha)       ret = ret.add('a', 'z').add('A', 'Z');
+    if (flags & Alphabet::sub_delims)  ret = ret.add("!$&'()*+,;=");
+    if (flags & Alphabet::gen_delims)  ret = ret.add(":/?#[]@");
+    if (flags & Alphabet::mark)        ret = ret.add("-._~");
+    if (flags & Alphabet::pchar_extra) ret = ret.add(":@");
+    if (flags & Alphabet::visible)     ret = ret.add(0x21, 0x7e);
+    return ret.add(extra);
+}
+
 struct URIComponent {
-    static const char scheme[256];
-    static const char user_info[256];
-    static const char host[256];
-    static const char path[256];
-    static const char path_segment[256];
-    static const char query[256];
-    static const char query_param[256];
-    static const char query_param_plus[256];
-    static const char fragment[256];
+    // '$' and '&' have always been encoded in components below except for scheme and query_param*, keep output stable
+    static constexpr Alphabet scheme           = make_alphabet(Alphabet::alpha | Alphabet::digit, "+-.");
+    static constexpr Alphabet user_info        = make_alphabet(Alphabet::unreserved | Alphabet::sub_delims, ":").remove("$&");
+    static constexpr Alphabet host             = make_alphabet(Alphabet::unreserved | Alphabet::sub_delims).remove("$&");
+    static constexpr Alphabet path             = make_alphabet(Alphabet::pchar, "/").remove("$&");
+    static constexpr Alphabet path_segment     = make_alphabet(Alphabet::pchar).remove("$&");
+    static constexpr Alphabet query            = make_alphabet(Alphabet::pchar, "/?").remove("$&");
+    static constexpr Alphabet query_param      = make_alphabet(Alphabet::unreserved);
+    static constexpr Alphabet query_param_plus = make_alphabet(Alphabet::unreserved).space_as('+');
+    static constexpr Alphabet fragment         = make_alphabet(Alphabet::pchar, "/?").remove("$&");
+
+    // WHATWG URL standard percent-encode sets (as complements) and others
+    static constexpr Alphabet whatwg_path      = make_alphabet(Alphabet::visible).remove("\"#<>?`{}");
+    static constexpr Alphabet whatwg_userinfo  = whatwg_path.remove("/:;=@[\\]^|");
+    static constexpr Alphabet form_urlencoded  = make_alphabet(Alphabet::alpha | Alphabet::digit, "*-._").space_as('+');
+    static constexpr Alphabet oauth            = make_alphabet(Alphabet::unreserved); // RFC 5849 3.6
 };
 
-size_t encode_uri_component (const string_view src, char* dest, const char* component = URIComponent::query_param);
+// instruction set used by codec kernels, selected once at startup according to CPU capabilities
+enum class SimdLevel { scalar, sse42, avx2, avx512 };
+
+SimdLevel   simd_level      ();
+// force lower level (for testing/benchmarking), returns the level actually set. Safe to call while other threads use the
+// codec: each call picks the kernels once, so calls already running finish with the previous level
+SimdLevel   simd_level      (SimdLevel);
+const char* simd_level_name (SimdLevel);
+
+size_t encode_uri_component (const string_view src, char* dest, const Alphabet& component = URIComponent::query_param);
 size_t decode_uri_component (const string_view src, char* dest);
+size_t encoded_length       (const string_view src, const Alphabet& component = URIComponent::query_param);
+
+size_t find_first_unsafe  (const string_view src, const Alphabet& component = URIComponent::query_param); // first byte that needs encoding or npos
+size_t find_first_encoded (const string_view src);                                                    // first byte that decoding changes or npos
 
-inline void encode_uri_component (const string_view src, string& dest, const char* component = URIComponent::query_param) {
-    size_t final_size = encode_uri_component(src, dest.reserve(src.length()*3), component);
+inline void encode_uri_component (const string_view src, string& dest, const Alphabet& component = URIComponent::query_param) {
+    size_t final_size = encode_uri_component(src, dest.reserve(encoded_length(src, component)), component);
     dest.length(final_size);
 }
 
@@ -28,7 +119,7 @@ inline void decode_uri_component (const string_view src, string& dest) {
     dest.length(final_size);
 }
 
-inline string encode_uri_component (const string_view src, const char* component = URIComponent::query_param) {
+inline string encode_uri_component (const string_view src, const Alphabet& component = URIComponent::query_param) {
     string ret;
     encode_uri_component(src, ret, component);
     return ret;
@@ -40,4 +131,82 @@ inline string decode_uri_component (const string_view src) {
     return ret;
 }
 
+// overloads for panda::string source share it instead of copying when nothing is to be changed
+
+template <class T, typename = typename std::enable_if<std::is_same<T,string>::value>::type>
+inline size_t encode_uri_component (const T& src, char* dest, const Alphabet& component = URIComponent::query_param) {
+    return encode_uri_component(string_view(src), dest, component);
+}
+
+template <class T, typename = typename std::enable_if<std::is_same<T,string>::value>::type>
+inline void encode_uri_component (const T& src, string& dest, const Alphabet& component = URIComponent::query_param) {
+    if (find_first_unsafe(src, component) == string::npos) dest = src;
+    else encode_uri_component(string_view(src), dest, component);
+}
+
+template <class T, typename = typename std::enable_if<std::is_same<T,string>::value>::type>
+inline void decode_uri_component (const T& src, string& dest) {
+    if (find_first_encoded(src) == string::npos) dest = src;
+    else decode_uri_component(string_view(src), dest);
+}
+
+template <class T, typename = typename std::enable_if<std::is_same<T,string>::value>::type>
+inline string encode_uri_component (const T& src, const Alphabet& component = URIComponent::query_param) {
+    if (find_first_unsafe(src, component) == string::npos) return src;
+    return encode_uri_component(string_view(src), component);
+}
+
+template <class T, typename = typename std::enable_if<std::is_same<T,string>::value>::type>
+inline string decode_uri_component (const T& src) {
+    if (find_first_encoded(src) == string::npos) return src;
+    return decode_uri_component(string_view(src));
+}
+
+// decodes str in place, reusing its buffer if it's not shared
+void decode_uri_component_inplace (string& str);
+
+// Incremental encoder/decoder for input split into chunks at arbitrary points. Output of each call goes to char* dest
+// (which must have room for encoded_length(chunk) bytes when encoding and for chunk.length() bytes when decoding)
+// or is appended to a string. Decoder carries escape sequence split between chunks over to the next call; concatenated
+// output including finish() is the same as decoding the whole input at once.
+struct StreamEncoder {
+    StreamEncoder (const Alphabet& component = URIComponent::query_param) : _component(component) {}
+
+    size_t encode (const string_view chunk, char* dest) const { return encode_uri_component(chunk, dest, _component); }
+
+    void encode (const string_view chunk, string& dest) const {
+        char* buf = dest.reserve(dest.length() + encoded_length(chunk, _component)) + dest.length();
+        dest.length(dest.length() + encode(chunk, buf));
+    }
+
+private:
+    Alphabet _component;
+};
+
+struct StreamDecoder {
+    size_t decode (string_view chunk, char* dest);
+    size_t finish (char* dest); // flushes incomplete escape left at the end of input, writes at most 1 byte
+
+    void decode (const string_view chunk, string& dest) {
+        char* buf = dest.reserve(dest.length() + chunk.length()) + dest.length();
+        dest.length(dest.length() + decode(chunk, buf));
+    }
+
+    void finish (string& dest) {
+        char* buf = dest.reserve(dest.length() + 1) + dest.length();
+        dest.length(dest.length() + finish(buf));
+    }
+
+    size_t pending () const { return _npending; } // number of carried over bytes
+
+private:
+    char   _pending[2];
+    size_t _npending = 0;
+};
+
+// Batch versions for many small strings: results for src[0..n) are appended one after another to dest, which is reserved
+// once for all of them. i-th result is dest.substr(offsets[i], offsets[i+1] - offsets[i]), offsets must have room for n+1 items.
+void encode_uri_components (const string_view* src, size_t n, string& dest, size_t* offsets, const Alphabet& component = URIComponent::query_param);
+void decode_uri_components (const string_view* src, size_t n, string& dest, size_t* offsets);
+
 }}
@@ -3,14 +3,16 @@
 
 namespace panda { namespace uri {
 
-struct URI::ftp : Strict<URI::ftp> {
+struct URI::ftp final : Strict<URI::ftp> {
     using Strict<URI::ftp>::Strict;
+    using Strict<URI::ftp>::operator=;
 
     static string default_scheme () { return "ftp"; }
 };
 
-struct URI::sftp : Strict<URI::sftp> {
+struct URI::sftp final : Strict<URI::sftp> {
     using Strict<URI::sftp>::Strict;
+    using Strict<URI::sftp>::operator=;
 
     static string default_scheme () { return "sftp"; }
 };
@@ -3,16 +3,18 @@
 
 namespace panda { namespace uri {
 
-struct URI::https : Strict<URI::https> {
+struct URI::https final : Strict<URI::https> {
     using Strict = Strict<URI::https>;
     using Strict::Strict;
+    using Strict::operator=;
 
     static string default_scheme () { return "https"; }
 };
 
-struct URI::http : Strict<URI::http, URI::https> {
+struct URI::http final : Strict<URI::http, URI::https> {
     using Strict = Strict<URI::http, URI::https>;
     using Strict::Strict;
+    using Strict::operator=;
 
     static string default_scheme () { return "http"; }
 };
@@ -25,7 +25,7 @@ static const int uri_parser_en_uri = 171;
 #define SAVE(dest)  dest = str.substr(mark, p - ps - mark);
 #define NSAVE(dest) dest = acc; acc = 0
 
-bool URI::_parse (const string& str, bool& authority_has_pct) {
+bool URI::_parse (const string& str, ParseContext& ctx) {
     const char* ps  = str.data();
     const char* p   = ps;
     const char* pe  = p + str.length();
@@ -550,7 +550,7 @@ case 180:
 	goto st0;
 tr200:
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st9;
 tr193:
 #line 10 "src/panda/uri/parser.rl"
@@ -558,7 +558,7 @@ tr193:
         mark = p - ps;
     }
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st9;
 st9:
 	if ( ++p == pe )
@@ -663,7 +663,7 @@ case 11:
 	goto st0;
 tr12:
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st12;
 st12:
 	if ( ++p == pe )
@@ -763,7 +763,7 @@ case 183:
 	goto st0;
 tr211:
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st14;
 tr209:
 #line 10 "src/panda/uri/parser.rl"
@@ -771,7 +771,7 @@ tr209:
         mark = p - ps;
     }
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st14;
 st14:
 	if ( ++p == pe )
@@ -3327,7 +3327,7 @@ case 186:
 	goto st0;
 tr215:
 #line 19 "src/panda/uri/parser.rl"
-	{ SAVE(_scheme); }
+	{ SAVE(_scheme); if (ctx.filter && !ctx.filter(_scheme)) { ctx.scheme_rejected = true; {p++; cs = 187; goto _out;} } }
 	goto st187;
 st187:
 	if ( ++p == pe )
@@ -3618,7 +3618,7 @@ case 187:
 	}
 
 #line 115 "src/panda/uri/parser.rl"
-    
+    ctx.position = p - ps;
     return cs >= uri_parser_first_final;
 }
 
@@ -16,7 +16,7 @@ namespace panda { namespace uri {
         acc += *p - '0';
     }
     
-    action scheme   { SAVE(_scheme); }
+    action scheme   { SAVE(_scheme); if (ctx.filter && !ctx.filter(_scheme)) { ctx.scheme_rejected = true; fbreak; } }
     action host     { SAVE(_host); }
     action port     { NSAVE(_port); }
     action userinfo { SAVE(_user_info); }
@@ -24,7 +24,7 @@ namespace panda { namespace uri {
     action query    { SAVE(_qstr); }
     action fragment { SAVE(_fragment); }
     
-    action auth_pct { authority_has_pct = true; }
+    action auth_pct { ctx.authority_has_pct = true; }
     
     sub_delim   = "!" | "$" | "&" | "'" | "(" | ")" | "*" | "+" | "," | ";" | "=";
     gen_delim   = ":" | "/" | "?" | "#" | "[" | "]" | "@";
@@ -102,7 +102,7 @@ namespace panda { namespace uri {
 #define SAVE(dest)  dest = str.substr(mark, p - ps - mark);
 #define NSAVE(dest) dest = acc; acc = 0
 
-bool URI::_parse (const string& str, bool& authority_has_pct) {
+bool URI::_parse (const string& str, ParseContext& ctx) {
     const char* ps  = str.data();
     const char* p   = ps;
     const char* pe  = p + str.length();
@@ -112,7 +112,7 @@ bool URI::_parse (const string& str, bool& authority_has_pct) {
     int acc = 0;
     
     %% write exec;
-    
+    ctx.position = p - ps;
     return cs >= uri_parser_first_final;
 }
 
@@ -18,7 +18,7 @@ static const int uri_parser_ext_en_uri = 171;
 #line 20 "src/panda/uri/parser_ext.rl"
 
 
-bool URI::_parse_ext (const string& str, bool& authority_has_pct) {
+bool URI::_parse_ext (const string& str, ParseContext& ctx) {
     const char* ps  = str.data();
     const char* p   = ps;
     const char* pe  = p + str.length();
@@ -599,7 +599,7 @@ case 181:
 	goto st0;
 tr206:
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st9;
 tr199:
 #line 10 "src/panda/uri/parser.rl"
@@ -607,7 +607,7 @@ tr199:
         mark = p - ps;
     }
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st9;
 st9:
 	if ( ++p == pe )
@@ -712,7 +712,7 @@ case 11:
 	goto st0;
 tr12:
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st12;
 st12:
 	if ( ++p == pe )
@@ -812,7 +812,7 @@ case 184:
 	goto st0;
 tr217:
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st14;
 tr215:
 #line 10 "src/panda/uri/parser.rl"
@@ -820,7 +820,7 @@ tr215:
         mark = p - ps;
     }
 #line 27 "src/panda/uri/parser.rl"
-	{ authority_has_pct = true; }
+	{ ctx.authority_has_pct = true; }
 	goto st14;
 st14:
 	if ( ++p == pe )
@@ -3376,7 +3376,7 @@ case 187:
 	goto st0;
 tr221:
 #line 19 "src/panda/uri/parser.rl"
-	{ SAVE(_scheme); }
+	{ SAVE(_scheme); if (ctx.filter && !ctx.filter(_scheme)) { ctx.scheme_rejected = true; {p++; cs = 188; goto _out;} } }
 	goto st188;
 st188:
 	if ( ++p == pe )
@@ -3674,7 +3674,7 @@ case 188:
 	}
 
 #line 33 "src/panda/uri/parser_ext.rl"
-    
+    ctx.position = p - ps;
     if (ext_chars) { // we must parse and invalidate source query string to produce valid uri on output
         parse_query();
         _qstr.clear();
@@ -19,7 +19,7 @@ namespace panda { namespace uri {
     write data;
 }%%
 
-bool URI::_parse_ext (const string& str, bool& authority_has_pct) {
+bool URI::_parse_ext (const string& str, ParseContext& ctx) {
     const char* ps  = str.data();
     const char* p   = ps;
     const char* pe  = p + str.length();
@@ -30,7 +30,7 @@ bool URI::_parse_ext (const string& str, bool& authority_has_pct) {
     bool ext_chars = false;
     
     %% write exec;
-    
+    ctx.position = p - ps;
     if (ext_chars) { // we must parse and invalidate source query string to produce valid uri on output
         parse_query();
         _qstr.clear();
@@ -3,8 +3,9 @@
 
 namespace panda { namespace uri {
 
-struct URI::socks : Strict<URI::socks> {
+struct URI::socks final : Strict<URI::socks> {
     using Strict<URI::socks>::Strict;
+    using Strict<URI::socks>::operator=;
 
     static string default_scheme () { return "socks5"; }
 };
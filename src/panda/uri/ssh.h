@@ -3,8 +3,9 @@
 
 namespace panda { namespace uri {
 
-struct URI::ssh : Strict<URI::ssh> {
+struct URI::ssh final : Strict<URI::ssh> {
     using Strict<URI::ssh>::Strict;
+    using Strict<URI::ssh>::operator=;
 
     static string default_scheme () { return "ssh"; }
 };
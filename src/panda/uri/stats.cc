@@ -0,0 +1,140 @@
+#include <panda/uri/stats.h>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+namespace panda { namespace uri { namespace stats {
+
+static const char* counter_names[]   = {"parse", "parse_failed", "scheme_rejected", "parse_query", "compile_query", "scheme_detach"};
+static const char* histogram_names[] = {"uri_length", "query_length", "query_params"};
+
+static_assert(sizeof(counter_names)   / sizeof(*counter_names)   == counters_count,   "counter names");
+static_assert(sizeof(histogram_names) / sizeof(*histogram_names) == histograms_count, "histogram names");
+
+const char* name (Counter c)   { return counter_names[size_t(c)]; }
+const char* name (Histogram h) { return histogram_names[size_t(h)]; }
+
+Snapshot& Snapshot::operator+= (const Snapshot& oth) {
+    for (size_t i = 0; i < counters_count; ++i) counters[i] += oth.counters[i];
+    for (size_t i = 0; i < histograms_count; ++i)
+        for (size_t j = 0; j < buckets_count; ++j) histograms[i][j] += oth.histograms[i][j];
+    return *this;
+}
+
+Snapshot& Snapshot::operator-= (const Snapshot& oth) {
+    for (size_t i = 0; i < counters_count; ++i) counters[i] -= oth.counters[i];
+    for (size_t i = 0; i < histograms_count; ++i)
+        for (size_t j = 0; j < buckets_count; ++j) histograms[i][j] -= oth.histograms[i][j];
+    return *this;
+}
+
+string Snapshot::to_string () const {
+    string ret;
+    char buf[128];
+    for (size_t i = 0; i < counters_count; ++i) {
+        int len = snprintf(buf, sizeof(buf), "%s %llu\n", counter_names[i], (unsigned long long)counters[i]);
+        ret += string_view(buf, len);
+    }
+    for (size_t i = 0; i < histograms_count; ++i) {
+        for (size_t j = 0; j < buckets_count; ++j) {
+            if (!histograms[i][j]) continue;
+            unsigned long long from = j ? 1ULL << (j-1) : 0;
+            unsigned long long cnt  = histograms[i][j];
+            int len = j == buckets_count - 1
+                ? snprintf(buf, sizeof(buf), "%s [%llu, inf) %llu\n", histogram_names[i], from, cnt)
+                : snprintf(buf, sizeof(buf), "%s [%llu, %llu) %llu\n", histogram_names[i], from, j ? from * 2 : 1, cnt);
+            ret += string_view(buf, len);
+        }
+    }
+    return ret;
+}
+
+#ifdef PANDA_URI_STATS
+
+namespace {
+    // written only by the owning thread, so relaxed load+store is enough for increments; atomics are there to let
+    // snapshot() read them from other threads. Counters only grow: reset() remembers a baseline instead of zeroing them
+    struct ThreadStats {
+        std::atomic<uint64_t> counters[counters_count];
+        std::atomic<uint64_t> histograms[histograms_count][buckets_count];
+
+        ThreadStats ();
+        ~ThreadStats ();
+
+        static void inc (std::atomic<uint64_t>& v) { v.store(v.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+        void add_to (Snapshot& s) const {
+            for (size_t i = 0; i < counters_count; ++i) s.counters[i] += counters[i].load(std::memory_order_relaxed);
+            for (size_t i = 0; i < histograms_count; ++i)
+                for (size_t j = 0; j < buckets_count; ++j) s.histograms[i][j] += histograms[i][j].load(std::memory_order_relaxed);
+        }
+    };
+
+    struct Registry {
+        std::mutex                mutex;
+        std::vector<ThreadStats*> threads;
+        Snapshot                  retired; // stats of threads that have exited
+        Snapshot                  base;    // total at last reset(), subtracted by snapshot()
+
+        Snapshot total () const {
+            Snapshot ret = retired;
+            for (auto t : threads) t->add_to(ret);
+            return ret;
+        }
+    };
+
+    Registry& registry () {
+        static Registry* r = new Registry(); // never destroyed: threads may exit after static destructors have run
+        return *r;
+    }
+
+    ThreadStats::ThreadStats () {
+        for (auto& v : counters) v.store(0, std::memory_order_relaxed);
+        for (auto& h : histograms) for (auto& v : h) v.store(0, std::memory_order_relaxed);
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(this);
+    }
+
+    ThreadStats::~ThreadStats () {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        add_to(r.retired);
+        r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+    }
+
+    thread_local ThreadStats local;
+}
+
+void count (Counter c) {
+    ThreadStats::inc(local.counters[size_t(c)]);
+}
+
+void record (Histogram h, uint64_t value) {
+    ThreadStats::inc(local.histograms[size_t(h)][bucket(value)]);
+}
+
+Snapshot snapshot () {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Snapshot ret = r.total();
+    ret -= r.base;
+    return ret;
+}
+
+void reset () {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.base = r.total();
+}
+
+#else
+
+Snapshot snapshot () { return {}; }
+void     reset    () {}
+
+#endif
+
+}}}
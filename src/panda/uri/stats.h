@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <panda/string.h>
+
+namespace panda { namespace uri { namespace stats {
+
+// Runtime counters and log2-bucketed size histograms. Collected only when the library is built with PANDA_URI_STATS
+// defined (cmake -DPANDA_URI_STATS=ON), otherwise hooks are empty inlines and snapshot() is always zero.
+// Every thread writes its own counters; snapshot() sums all live threads plus the threads that have already exited.
+
+#ifdef PANDA_URI_STATS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+enum class Counter {
+    parse,           // URI::parse() calls
+    parse_failed,    // parse() calls that rejected the input
+    scheme_rejected, // parse() calls stopped by scheme filter of a typed URI
+    parse_query,     // query string -> Query conversions
+    compile_query,   // Query -> query string conversions
+    scheme_detach,   // scheme copied out of the parsed source to be lowercased
+    _count
+};
+
+enum class Histogram {
+    uri_length,      // length of parsed URI strings
+    query_length,    // length of parsed and compiled query strings
+    query_params,    // number of params produced by parse_query()
+    _count
+};
+
+constexpr size_t counters_count   = size_t(Counter::_count);
+constexpr size_t histograms_count = size_t(Histogram::_count);
+constexpr size_t buckets_count    = 65; // bucket 0 is for value 0, bucket N (N>0) for values in [2^(N-1), 2^N)
+
+inline size_t bucket (uint64_t value) { return value ? 64 - __builtin_clzll(value) : 0; }
+
+struct Snapshot {
+    using Buckets = std::array<uint64_t, buckets_count>;
+
+    std::array<uint64_t, counters_count>  counters   = {};
+    std::array<Buckets,  histograms_count> histograms = {};
+
+    uint64_t       operator[] (Counter c)   const { return counters[size_t(c)]; }
+    const Buckets& operator[] (Histogram h) const { return histograms[size_t(h)]; }
+
+    Snapshot& operator+= (const Snapshot&);
+    Snapshot& operator-= (const Snapshot&);
+
+    // "name value" lines for counters, then "name [from, to) count" lines for non-empty histogram buckets
+    string to_string () const;
+};
+
+const char* name (Counter);
+const char* name (Histogram);
+
+Snapshot snapshot ();
+void     reset    (); // makes snapshot() count from now on; never writes to counters, so threads may keep parsing meanwhile
+
+#ifdef PANDA_URI_STATS
+void count  (Counter);
+void record (Histogram, uint64_t value);
+#else
+inline void count  (Counter)            {}
+inline void record (Histogram, uint64_t) {}
+#endif
+
+}}}
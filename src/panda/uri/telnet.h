@@ -3,8 +3,9 @@
 
 namespace panda { namespace uri {
 
-struct URI::telnet : Strict<URI::telnet> {
+struct URI::telnet final : Strict<URI::telnet> {
     using Strict<URI::telnet>::Strict;
+    using Strict<URI::telnet>::operator=;
 
     static string default_scheme () { return "telnet"; }
 };
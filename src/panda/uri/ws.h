@@ -3,14 +3,16 @@
 
 namespace panda { namespace uri {
 
-struct URI::wss : Strict<URI::wss> {
+struct URI::wss final : Strict<URI::wss> {
     using Strict<URI::wss>::Strict;
+    using Strict<URI::wss>::operator=;
 
     static string default_scheme () { return "wss"; }
 };
 
-struct URI::ws : Strict<URI::ws, URI::wss> {
+struct URI::ws final : Strict<URI::ws, URI::wss> {
     using Strict<URI::ws, URI::wss>::Strict;
+    using Strict<URI::ws, URI::wss>::operator=;
 
     static string default_scheme () { return "ws"; }
 };
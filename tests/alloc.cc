@@ -0,0 +1,95 @@
+#include "test.h"
+#include <vector>
+#include <alloc_counter.h>
+
+#define TEST(name) TEST_CASE("alloc: " name, "[alloc]")
+
+// Fixed allocation counts of hot operations. If one of these fails, something started to copy or allocate where it
+// did not before - fix that instead of bumping the number.
+
+template <class F>
+static uint64_t allocs_of (F&& f) {
+    auto before = alloc_counter::current().allocs;
+    f();
+    return alloc_counter::current().allocs - before;
+}
+
+// panda::string allocates via malloc, so gates are meaningless when only operator new is counted
+#define ALLOC_GATE if (!alloc_counter::counts_malloc()) return
+
+TEST("parse simple http uri") {
+    ALLOC_GATE;
+    string src = "http://example.com/path/to/file?a=1&b=2#frag";
+    URI uri(src);
+    CHECK(allocs_of([&]{ uri.assign(src); }) == 0);
+    CHECK(uri.host() == "example.com");
+
+    string src2 = "https://user@example.com:8080/path";
+    CHECK(allocs_of([&]{ uri.assign(src2); }) == 0);
+    CHECK(uri.port() == 8080);
+
+    string src3 = "ftp://example.com/file";
+    CHECK(allocs_of([&]{ uri.assign(src3); }) == 0);
+    CHECK(uri.scheme() == "ftp");
+}
+
+TEST("param reads") {
+    ALLOC_GATE;
+    URI uri("http://example.com/?a=1&b=2&c=3");
+    uri.query();
+    uint64_t n = allocs_of([&]{
+        CHECK(uri.param("b") == "2");
+        CHECK(uri.has_param("c"));
+        CHECK(!uri.has_param("d"));
+        CHECK(uri.param("d") == "");
+    });
+    CHECK(n == 0);
+}
+
+TEST("to_string on unchanged uri") {
+    ALLOC_GATE;
+    URI uri("http://example.com/path?a=1#frag");
+    auto str = uri.to_string();
+    string again;
+    CHECK(allocs_of([&]{ again = uri.to_string(); }) == 0);
+    CHECK(again == str);
+}
+
+TEST("encoding and decoding already-safe strings") {
+    ALLOC_GATE;
+    string src = "already-safe_string.1234";
+    string res;
+    CHECK(allocs_of([&]{ res = encode_uri_component(src); }) == 0);
+    CHECK(res == src);
+    CHECK(allocs_of([&]{ res = encode_uri_component(src, URIComponent::path); }) == 0);
+    CHECK(allocs_of([&]{ res = decode_uri_component(src); }) == 0);
+    CHECK(res == src);
+}
+
+TEST("move") {
+    ALLOC_GATE;
+    URI src("http://example.com/path?a=1&b=2#frag");
+    src.query();
+    src.to_string();
+    URI dst;
+    CHECK(allocs_of([&]{ dst = std::move(src); }) == 0);
+    CHECK(allocs_of([&]{ URI tmp(std::move(dst)); src = std::move(tmp); }) == 0);
+    CHECK(src.param("b") == "2");
+}
+
+TEST("vector reallocation") {
+    ALLOC_GATE;
+    std::vector<URI::http> list;
+    for (int i = 0; i < 4; ++i) list.emplace_back("http://example.com/path?a=1&b=2#frag");
+    for (auto& uri : list) uri.query();
+    CHECK(allocs_of([&]{ list.reserve(list.capacity() * 2); }) == 1); // the buffer itself, uris are moved
+    CHECK(list[3].param("b") == "2");
+}
+
+TEST("create typed uri") {
+    ALLOC_GATE;
+    string src = "https://example.com/path?a=1";
+    URISP uri = URI::create(src);
+    CHECK(allocs_of([&]{ uri = URI::create(src); }) == 1); // the object itself
+    CHECK_TYPE(uri, URI::https);
+}
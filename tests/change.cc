@@ -1,4 +1,5 @@
 #include "test.h"
+#include <type_traits>
 
 #define TEST(name) TEST_CASE("change: " name, "[change]")
 
@@ -86,3 +87,119 @@ TEST("location") {
     CHECK(uri.explicit_port() == 0);
     CHECK(uri.port() == 80);
 }
+
+TEST("cached string") {
+    URI uri("http://user@ya.ru:8080/my/path?a=b#hash");
+    auto str = uri.to_string();
+    CHECK(str == "http://user@ya.ru:8080/my/path?a=b#hash");
+    CHECK(uri.to_string().data() == str.data()); // shared, not rebuilt
+    CHECK(uri.relative() == "/my/path?a=b#hash");
+
+    SECTION("port") {
+        uri.port(81);
+        CHECK(uri.to_string() == "http://user@ya.ru:81/my/path?a=b#hash");
+        uri.port(0);
+        CHECK(uri.to_string() == "http://user@ya.ru/my/path?a=b#hash");
+        uri.port(65535);
+        CHECK(uri.to_string() == "http://user@ya.ru:65535/my/path?a=b#hash");
+        uri.fragment("other");
+        CHECK(uri.to_string() == "http://user@ya.ru:65535/my/path?a=b#other");
+        CHECK(str == "http://user@ya.ru:8080/my/path?a=b#hash"); // previously returned string is not affected
+    }
+
+    SECTION("fragment") {
+        uri.fragment("");
+        CHECK(uri.to_string() == "http://user@ya.ru:8080/my/path?a=b");
+        uri.fragment("new");
+        CHECK(uri.to_string() == "http://user@ya.ru:8080/my/path?a=b#new");
+        uri.port(1);
+        CHECK(uri.to_string() == "http://user@ya.ru:1/my/path?a=b#new");
+    }
+
+    SECTION("host") {
+        uri.host("mail.ru");
+        CHECK(uri.to_string() == "http://user@mail.ru:8080/my/path?a=b#hash");
+    }
+
+    SECTION("path") {
+        uri.path("");
+        CHECK(uri.to_string() == "http://user@ya.ru:8080?a=b#hash");
+        CHECK(uri.relative() == "/?a=b#hash");
+    }
+
+    SECTION("query") {
+        uri.param("c", "d");
+        CHECK(uri.to_string() == "http://user@ya.ru:8080/my/path?a=b&c=d#hash");
+        uri.query().erase(string("a"));
+        CHECK(uri.to_string() == "http://user@ya.ru:8080/my/path?c=d#hash");
+        uri.add_query("e=f");
+        CHECK(uri.to_string() == "http://user@ya.ru:8080/my/path?c=d&e=f#hash");
+    }
+
+    SECTION("copy") {
+        URI copy(uri);
+        copy.port(1);
+        CHECK(copy.to_string() == "http://user@ya.ru:1/my/path?a=b#hash");
+        CHECK(uri.to_string() == str);
+    }
+
+    SECTION("reparse") {
+        uri = "https://b.c";
+        CHECK(uri.to_string() == "https://b.c");
+    }
+}
+
+TEST("move") {
+    URI src("http://user@ya.ru:8080/my/path?a=b&c=d#hash");
+    src.query(); // parsed query tree must be moved, not rebuilt
+    auto* node = &*src.query().cbegin();
+
+    SECTION("construct") {
+        URI uri(std::move(src));
+        CHECK(uri.to_string() == "http://user@ya.ru:8080/my/path?a=b&c=d#hash");
+        CHECK(&*uri.query().cbegin() == node);
+        CHECK(uri.port() == 8080);
+        CHECK(src.empty());
+        CHECK(src.to_string() == "");
+    }
+
+    SECTION("assign") {
+        URI uri("https://other.com/?x=y");
+        uri = std::move(src);
+        CHECK(uri.to_string() == "http://user@ya.ru:8080/my/path?a=b&c=d#hash");
+        CHECK(&*uri.query().cbegin() == node);
+        CHECK(uri.param("c") == "d");
+        CHECK(src.empty());
+        src = "ftp://reused.com";
+        CHECK(src.host() == "reused.com");
+    }
+}
+
+// containers move elements on reallocation only if the move can't throw, otherwise they copy whole query trees
+static_assert(std::is_nothrow_move_constructible<URI>::value, "");
+static_assert(std::is_nothrow_move_constructible<URI::http>::value, "");
+static_assert(std::is_nothrow_move_assignable<URI::http>::value, "");
+
+TEST("rvalue setters") {
+    URI uri("http://ya.ru/path?a=b#hash");
+    uri.to_string();
+
+    uri.host(string("mail.ru"));
+    uri.user_info(string("user"));
+    uri.fragment(string("frag"));
+    CHECK(uri.to_string() == "http://user@mail.ru/path?a=b#frag");
+
+    uri.path(string("rel"));
+    CHECK(uri.path() == "/rel");
+    uri.path(string("/abs"));
+    CHECK(uri.to_string() == "http://user@mail.ru/abs?a=b#frag");
+
+    uri.query_string(string("c=d"));
+    CHECK(uri.param("c") == "d");
+
+    Query q{{"x", "1"}, {"y", "2"}};
+    auto* node = &*q.cbegin();
+    uri.query(std::move(q));
+    CHECK(&*uri.query().cbegin() == node);
+    CHECK(uri.to_string() == "http://user@mail.ru/abs?x=1&y=2#frag");
+}
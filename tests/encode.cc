@@ -1,7 +1,49 @@
 #include "test.h"
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #define TEST(name) TEST_CASE("encode: " name, "[encode]")
 
+// runs test body with every kernel set supported by CPU
+template <class F>
+static void for_each_simd_level (F&& f) {
+    auto saved = simd_level();
+    for (auto level : {SimdLevel::scalar, SimdLevel::sse42, SimdLevel::avx2, SimdLevel::avx512}) {
+        if (simd_level(level) != level) continue;
+        SECTION(simd_level_name(level)) { f(); }
+    }
+    simd_level(saved);
+}
+
+TEST("alphabet") {
+    auto unreserved = [](int c) { return isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~'; };
+    for (int c = 0; c < 256; ++c) {
+        CHECK(URIComponent::query_param.contains(c) == unreserved(c));
+        CHECK(URIComponent::query_param_plus.contains(c) == unreserved(c));
+        CHECK(URIComponent::path.contains(c) == (unreserved(c) || (c && strchr("!'()*+,;=:@/", c)))); // '$' and '&' have always been encoded
+    }
+    CHECK(URIComponent::query_param.space == 0);
+    CHECK(URIComponent::query_param_plus.space == '+');
+
+    constexpr auto custom = make_alphabet(0, "az\xD0");
+    static_assert(custom.contains('a') && !custom.contains('b'), "built at compile time");
+    for (int c = 0; c < 256; ++c) CHECK(custom.contains(c) == (c == 'a' || c == 'z' || c == 0xD0));
+
+    constexpr auto edited = make_alphabet(Alphabet::unreserved).remove("~").add("/").space_as('+');
+    CHECK(encode_uri_component("a~b/c d", edited) == "a%7Eb/c+d");
+    CHECK(make_alphabet(Alphabet::alpha).add(0x80, 0xFF).contains(0xFF));
+    CHECK(!make_alphabet(0).add(0, 0x7F).contains(0)); // '\0' is never copied as is
+}
+
+TEST("extra alphabets") {
+    CHECK(encode_uri_component("/a b?c#d{e}`~@:", URIComponent::whatwg_path) == "/a%20b%3Fc%23d%7Be%7D%60~@:");
+    CHECK(encode_uri_component("us:er@x/y;z|", URIComponent::whatwg_userinfo) == "us%3Aer%40x%2Fy%3Bz%7C");
+    CHECK(encode_uri_component("a b*~'.", URIComponent::form_urlencoded) == "a+b*%7E%27.");
+    CHECK(encode_uri_component("a b-._~!*", URIComponent::oauth) == "a%20b-._~%21%2A");
+    CHECK(encode_uri_component("\x7F\xD0", URIComponent::whatwg_path) == "%7F%D0");
+}
+
 TEST("encode") {
     CHECK(encode_uri_component("hello world") == "hello%20world");
     CHECK(encode_uri_component("http://ya.ru") == "http%3A%2F%2Fya.ru");
@@ -15,3 +57,226 @@ TEST("decode") {
     CHECK(decode_uri_component("http%3A%2F%2Fya.ru") == "http://ya.ru");
     CHECK(decode_uri_component("hello%20guy%21%20how%20ru%3F%20%D0%BF%D0%B8%D0%B7%D0%B4%D0%B5%D1%86%20%D0%BD%D0%B0%D1%85") == "hello guy! how ru? пиздец нах");
 }
+
+TEST("encode long strings") {
+    // must give the same result on vector and scalar paths with any alphabet
+    auto reference = [](string_view src, const Alphabet& a) {
+        static const char hex[] = "0123456789ABCDEF";
+        string ret;
+        for (unsigned char c : src) {
+            if (a.contains(c)) ret += c;
+            else if (c == ' ' && a.space) ret += a.space;
+            else {
+                ret += '%';
+                ret += hex[c >> 4];
+                ret += hex[c & 15];
+            }
+        }
+        return ret;
+    };
+
+    auto custom = make_alphabet(0, "\xD0").add('a', 'z').space_as('-');
+
+    string src;
+    for (int i = 0; i < 300; ++i) src += (i % 7 == 3) ? ' ' : (i % 13 == 5) ? '\xD0' : (i % 17 == 0) ? '_' : char('a' + i % 26);
+    string clean;
+    for (int i = 0; i < 300; ++i) clean += char('a' + i % 26);
+
+    for_each_simd_level([&]{
+        for (auto alphabet : {URIComponent::query_param, URIComponent::query_param_plus, URIComponent::path, URIComponent::host, custom}) {
+            for (size_t len = 0; len <= src.length(); len += 13) {
+                CHECK(encode_uri_component(string_view(src.data(), len), alphabet) == reference(string_view(src.data(), len), alphabet));
+                CHECK(encode_uri_component(string_view(clean.data(), len), alphabet) == reference(string_view(clean.data(), len), alphabet));
+            }
+        }
+    });
+}
+
+TEST("decode long strings") {
+    for_each_simd_level([]{
+        string src;
+        for (int i = 0; i < 20; ++i) src += "abcdefghijklmnopqrstuvwxyz0123456789";
+        CHECK(decode_uri_component(src) == src);
+        for (size_t i = 0; i < src.length(); i += 11) {
+            src[i] = ' ';
+            CHECK(decode_uri_component(encode_uri_component(src)) == src);
+            CHECK(decode_uri_component(encode_uri_component(src, URIComponent::query_param_plus)) == src);
+        }
+
+        string tail = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+        CHECK(decode_uri_component(tail + "%4") == tail + "4"); // incomplete escape at the end is dropped
+        CHECK(decode_uri_component(tail + "%") == tail);
+        CHECK(decode_uri_component(tail + "%4a%4A+") == tail + "JJ ");
+    });
+}
+
+TEST("simd level") {
+    auto level = simd_level();
+    CHECK(simd_level_name(level));
+    CHECK(simd_level(SimdLevel::scalar) == SimdLevel::scalar);
+    CHECK(encode_uri_component("hello world") == "hello%20world");
+    CHECK(simd_level(level) == level);
+}
+
+TEST("simd level switch while encoding") {
+    auto level = simd_level();
+    std::atomic<bool> stop(false);
+    std::thread switcher([&]{
+        for (int i = 0; !stop; ++i) simd_level(i % 2 ? level : SimdLevel::scalar);
+    });
+    int wrong = 0;
+    char buf[256];
+    for (int i = 0; i < 10000; ++i) {
+        size_t len = encode_uri_component("hello world/with some spaces and slashes/", buf);
+        if (string_view(buf, len) != "hello%20world%2Fwith%20some%20spaces%20and%20slashes%2F") ++wrong;
+    }
+    stop = true;
+    switcher.join();
+    CHECK(wrong == 0);
+    simd_level(level);
+}
+
+TEST("zero byte") {
+    for_each_simd_level([]{
+        string src(100, 'a');
+        src[50] = 0;
+        CHECK(encode_uri_component(src) == string(50, 'a') + "%00" + string(49, 'a'));
+        CHECK(find_first_unsafe(src) == 50);
+    });
+}
+
+TEST("find first unsafe/encoded") {
+    for_each_simd_level([]{
+        string src(200, 'a');
+        CHECK(find_first_unsafe(src) == string::npos);
+        CHECK(find_first_encoded(src) == string::npos);
+        for (size_t i : {0, 1, 15, 16, 31, 32, 63, 64, 100, 199}) {
+            string s = src;
+            s[i] = ' ';
+            CHECK(find_first_unsafe(s) == i);
+            CHECK(find_first_unsafe(s, URIComponent::query_param_plus) == i); // replaced bytes need encoding too
+            CHECK(find_first_encoded(s) == string::npos);
+            s[i] = '%';
+            CHECK(find_first_encoded(s) == i);
+            s[i] = '+';
+            CHECK(find_first_encoded(s) == i);
+        }
+    });
+}
+
+TEST("no copy when nothing to change") {
+    string src = "hello_world";
+    CHECK(encode_uri_component(src).data() == src.data());
+    CHECK(decode_uri_component(src).data() == src.data());
+    string dest;
+    encode_uri_component(src, dest);
+    CHECK(dest.data() == src.data());
+
+    CHECK(encode_uri_component(string("hello world")) == "hello%20world");
+    CHECK(decode_uri_component(string("hello%20world")) == "hello world");
+}
+
+TEST("decode in place") {
+    string str = "hello%20world+x";
+    str.buf(); // make sure it's not shared with anything
+    const char* buf = str.data();
+    decode_uri_component_inplace(str);
+    CHECK(str == "hello world x");
+    CHECK(str.data() == buf);
+
+    string copy = str = "a%20b";
+    decode_uri_component_inplace(str);
+    CHECK(str == "a b");
+    CHECK(copy == "a%20b");
+
+    str = "clean";
+    buf = str.data();
+    decode_uri_component_inplace(str);
+    CHECK(str.data() == buf);
+}
+
+TEST("encoded length") {
+    auto custom = make_alphabet(0, "\xD0").add('a', 'z').space_as('+');
+
+    string src;
+    for (int i = 0; i < 300; ++i) src += (i % 7 == 3) ? ' ' : (i % 13 == 5) ? '\xD0' : (i % 11 == 0) ? '\0' : char('a' + i % 26);
+
+    for_each_simd_level([&]{
+        for (auto alphabet : {URIComponent::query_param, URIComponent::query_param_plus, URIComponent::path, custom}) {
+            for (size_t len = 0; len <= src.length(); len += 7) {
+                string_view sv(src.data(), len);
+                CHECK(encoded_length(sv, alphabet) == encode_uri_component(sv, alphabet).length());
+            }
+        }
+    });
+}
+
+TEST("batch") {
+    std::vector<string> strings;
+    for (int i = 0; i < 200; ++i) {
+        string s;
+        for (int j = 0; j < i % 70; ++j) s += (j % 9 == 4) ? ' ' : (j % 23 == 7) ? '/' : char('a' + (i + j) % 26);
+        strings.push_back(s);
+    }
+    std::vector<string_view> src(strings.begin(), strings.end());
+
+    for_each_simd_level([&]{
+        string dest = "prefix";
+        std::vector<size_t> offsets(src.size() + 1);
+        encode_uri_components(src.data(), src.size(), dest, offsets.data(), URIComponent::query_param_plus);
+        CHECK(dest.substr(0, 6) == "prefix");
+        CHECK(offsets.front() == 6);
+        CHECK(offsets.back() == dest.length());
+
+        std::vector<string_view> encoded;
+        for (size_t i = 0; i < src.size(); ++i) {
+            encoded.push_back(string_view(dest.data() + offsets[i], offsets[i+1] - offsets[i]));
+            CHECK(encoded.back() == encode_uri_component(src[i], URIComponent::query_param_plus));
+        }
+
+        string decoded;
+        decode_uri_components(encoded.data(), encoded.size(), decoded, offsets.data());
+        CHECK(offsets.front() == 0);
+        for (size_t i = 0; i < src.size(); ++i) CHECK(decoded.substr(offsets[i], offsets[i+1] - offsets[i]) == strings[i]);
+
+        encode_uri_components(nullptr, 0, decoded, offsets.data());
+        CHECK(offsets[0] == decoded.length());
+    });
+}
+
+TEST("stream decoder") {
+    std::vector<string> inputs = {"", "%", "%4", "%41", "a%4", "a%%", "a%+", "%%%41", "ab%2", "x+y%20z%", "%4%41%", string("a\0b", 3)};
+    string big;
+    for (int i = 0; i < 300; ++i) big += (i % 5 == 0) ? "%D0%BF" : (i % 7 == 0) ? "%%" : (i % 3 == 0) ? "+" : "ab";
+    inputs.push_back(big);
+
+    for_each_simd_level([&]{
+        for (auto& src : inputs) {
+            string expected = decode_uri_component(string_view(src));
+            for (size_t step = 1; step <= 5; ++step) {
+                StreamDecoder dec;
+                string out;
+                for (size_t pos = 0; pos < src.length(); pos += step) dec.decode(string_view(src).substr(pos, step), out);
+                dec.finish(out);
+                CHECK(out == expected);
+                CHECK(dec.pending() == 0);
+            }
+        }
+    });
+
+    StreamDecoder dec;
+    char buf[4];
+    CHECK(dec.decode("ab%", buf) == 2);
+    CHECK(dec.pending() == 1);
+    CHECK(dec.decode("4", buf) == 0);
+    CHECK(dec.decode("1", buf) == 1);
+    CHECK(buf[0] == 'A');
+}
+
+TEST("stream encoder") {
+    StreamEncoder enc(URIComponent::query_param_plus);
+    string out;
+    enc.encode("hello wo", out);
+    enc.encode("rld!", out);
+    CHECK(out == "hello+world%21");
+}
@@ -0,0 +1,71 @@
+#include "test.h"
+#include <vector>
+#include <algorithm>
+
+#define TEST(name) TEST_CASE("form: " name, "[form]")
+
+using Pairs = std::vector<std::pair<string,string>>;
+
+static Pairs parse (const string& src, size_t step, FormParser::Filter filter = {}, char delim = '&') {
+    Pairs ret;
+    string value;
+    FormParser parser([&](const string& key, const string_view& piece, bool last) {
+        value += piece;
+        if (!last) return;
+        ret.push_back({key, value});
+        value.clear();
+    }, delim);
+    parser.filter = filter;
+    for (size_t pos = 0; pos < src.length(); pos += step) parser.feed(string_view(src).substr(pos, step));
+    parser.finish();
+    return ret;
+}
+
+TEST("same pairs as query parser") {
+    string src = "p1=v1&p2=v2&p3=a%20b&p2=v2v2&=empty&empty=&novalue&k%3Dey=v%3Dal=ue&";
+    URI uri("http://host/?" + src);
+    Pairs expected;
+    for (auto& row : uri.query()) expected.push_back({row.first, row.second});
+    std::sort(expected.begin(), expected.end()); // query is ordered by key, while form parser reports pairs in input order
+
+    for (size_t step = 1; step <= src.length(); ++step) {
+        auto res = parse(src, step);
+        std::sort(res.begin(), res.end());
+        CHECK(res == expected);
+    }
+}
+
+TEST("plus is space") {
+    CHECK(parse("a+b=c+d", 1) == Pairs{{"a b", "c d"}});
+    CHECK(parse("q=%D0%BF%D1%80%D0%B8+%D0%B2%D0%B5%D1%82", 2) == Pairs{{"q", "при вет"}});
+}
+
+TEST("empty input") {
+    CHECK(parse("", 1).empty());
+}
+
+TEST("filter") {
+    auto res = parse("a=1&skip=%41%42&b=2&skip&c", 3, [](const string& key) { return key != "skip"; });
+    CHECK(res == Pairs{{"a", "1"}, {"b", "2"}, {"c", ""}});
+}
+
+TEST("semicolon delimiter") {
+    CHECK(parse("a=1;b=2&3", 2, {}, ';') == Pairs{{"a", "1"}, {"b", "2&3"}});
+}
+
+TEST("value comes in pieces") {
+    std::vector<string> pieces;
+    FormParser parser([&](const string&, const string_view& piece, bool) { pieces.push_back(string(piece)); });
+    parser.feed("key=abc");
+    parser.feed("def%2");
+    parser.feed("0gh");
+    parser.finish();
+    CHECK(pieces == std::vector<string>{"abc", "def", " gh", ""});
+}
+
+TEST("key length limit") {
+    FormParser parser([](const string&, const string_view&, bool) {});
+    parser.max_key_length = 4;
+    parser.feed("abcd=1&ab");
+    CHECK_THROWS_AS(parser.feed("cde=2"), URIError);
+}
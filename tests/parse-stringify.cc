@@ -1,5 +1,6 @@
 #include "test.h"
 #include <string>
+#include <sstream>
 
 #define TEST(name) TEST_CASE("parse-stringify: " name, "[parse-stringify]")
 
@@ -208,3 +209,72 @@ TEST("bad") {
     CHECK(URI("http://api.odnokl\x5C\x00\x03\x06\x00\x00\x00\x00\x00\x00\x00\x23\xC3\xABlq\x1B\x00\x02") == URI()); // null byte in uri. should NOT core dump. Stop parsing url on null byte
     test_wrong("https://jopa.com:123/://asd/?:hello?://yo?u/#lalala://hello/?a=b&jopa=#privet");
 }
+
+TEST("try_parse") {
+    ParseError err;
+    auto uri = URI::try_parse("http://ya.ru/path?a=b", err);
+    CHECK(!err);
+    CHECK(err.kind == ParseError::none);
+    CHECK(uri.host() == "ya.ru");
+
+    auto check = [&](string src, size_t pos) {
+        ParseError err;
+        auto uri = URI::try_parse(src, err);
+        CHECK(err.kind == ParseError::syntax);
+        CHECK(err.position == pos);
+        CHECK(uri == URI());
+    };
+    check("http://cool@user@ya.ru", 16);
+    check("http://ya.ru#my#frag", 15);
+    check("http://[::1", 11); // input ended too early
+    check("http://ya.ru/a b", 14);
+
+    uri = URI::try_parse("http://ya.ru/?a={b}", err, URI::Flags::allow_extended_chars);
+    CHECK(!err);
+    CHECK(uri.param("a") == "{b}");
+
+    URI reused("http://ya.ru");
+    CHECK(!reused.try_assign("http://ya.ru#a#b", err));
+    CHECK(reused.empty());
+}
+
+TEST("serialize to buffer") {
+    auto check = [](const URI& uri, bool relative) {
+        auto str = uri.to_string(relative);
+        CHECK(uri.serialized_length(relative) == str.length());
+        char buf[256];
+        char* end = uri.serialize_to(buf, relative);
+        CHECK(string(buf, end - buf) == str);
+
+        string dest = "GET ";
+        uri.append_to(dest, relative);
+        CHECK(dest == "GET " + str);
+
+        URI::Slice slices[URI::max_slices];
+        string sbuf;
+        size_t cnt = uri.serialize_slices(slices, sbuf, relative);
+        CHECK(cnt <= URI::max_slices);
+        string joined;
+        for (size_t i = 0; i < cnt; ++i) joined.append(slices[i].base, slices[i].len);
+        CHECK(joined == str);
+
+        if (!relative) {
+            std::ostringstream os;
+            os << uri;
+            CHECK(os.str() == std::string(str));
+        }
+    };
+
+    for (auto s : {"http://user%20name@ho%20st:8080/my/path?a=b#hash", "http://[::1]/", "//ya.ru", "mailto:syber@crazypanda.ru", "/path?q#f", "", "?q"}) {
+        SECTION(s) {
+            URI uri(s);
+            check(uri, false); // not cached yet
+            check(uri, true);
+            uri.to_string();
+            check(uri, false); // cached
+            check(uri, true);
+            uri.param("a", "c d");
+            check(uri, false);
+        }
+    }
+}
@@ -156,3 +156,31 @@ TEST("bug test (no sync query for param())") {
     CHECK(uri.to_string() == "https://graph.facebook.com/v2.2?batch=123");
 
 }
+
+TEST("query writer to string") {
+    string dest = "https://ya.ru/?";
+    QueryWriter(dest).add("a b", "c&d").add("n", 42).add("neg", -9223372036854775807LL - 1).add("e", "");
+    CHECK(dest == "https://ya.ru/?a%20b=c%26d&n=42&neg=-9223372036854775808&e=");
+
+    string semi;
+    QueryWriter w(semi, ';');
+    for (int i = 0; i < 100; ++i) w.add("k", i);
+    CHECK(URI("http://ya.ru?" + semi, URI::Flags::query_param_semicolon).query().count(string("k")) == 100);
+}
+
+TEST("query writer to uri") {
+    URI uri("https://ya.ru/my/path?a=b#frag");
+    CHECK(uri.to_string() == "https://ya.ru/my/path?a=b#frag");
+    QueryWriter(uri).add("c", "d e").add("n", 1u);
+    CHECK(uri.query_string() == "a=b&c=d%20e&n=1");
+    CHECK(uri.query() == Query({{"a", "b"}, {"c", "d e"}, {"n", "1"}}));
+    CHECK(uri.to_string() == "https://ya.ru/my/path?a=b&c=d%20e&n=1#frag");
+
+    uri.param("a", "x"); // pending query changes are compiled before writing
+    QueryWriter(uri).add("z", "1");
+    CHECK(uri.query() == Query({{"a", "x"}, {"c", "d e"}, {"n", "1"}, {"z", "1"}}));
+
+    URI semi("https://ya.ru/?a=b", URI::Flags::query_param_semicolon);
+    QueryWriter(semi).add("c", "d");
+    CHECK(semi.query_string() == "a=b;c=d");
+}
@@ -9,12 +9,24 @@ struct MyScheme2 : URI::Strict<MyScheme2> {
     static string default_scheme () { return "myscheme2"; }
 };
 
+struct MyScheme3 : URI::Strict<MyScheme3> {
+    using URI::Strict<MyScheme3>::Strict;
+    static string default_scheme () { return "myscheme3"; }
+};
+
+struct Unregistered : URI::Strict<Unregistered> {
+    using URI::Strict<Unregistered>::Strict;
+    static string default_scheme () { return "notype"; }
+};
+
 struct RegisterSchems : Catch::EventListenerBase {
     using EventListenerBase::EventListenerBase; // inherit constructor
 
     void testRunStarting( Catch::TestRunInfo const&) override {
         URI::register_scheme("myscheme1", 6666, true);
         URI::register_scheme("myscheme2", &typeid(MyScheme2), [](const URI& u)->URI*{ return new MyScheme2(u);  }, 7777, false);
+        URI::register_scheme<MyScheme3>("myscheme3", 8888);
+        URI::register_scheme("notype", nullptr, [](const URI& u)->URI*{ return new URI(u); }, 9999);
     }
 };
 CATCH_REGISTER_LISTENER(RegisterSchems);
@@ -38,3 +50,43 @@ TEST("full scheme") {
     uri = new URI("myscheme2://ya.ru");
     CHECK(uri->port() == 7777);
 }
+
+TEST("typed registration") {
+    auto uri = URI::create("myscheme3://ya.ru/path?a=b");
+    CHECK_TYPE(uri, MyScheme3);
+    CHECK(uri->port() == 8888);
+    CHECK(!uri->secure());
+    CHECK(uri->param("a") == "b");
+    CHECK_THROWS_AS(*uri = "myscheme2://ya.ru", WrongScheme);
+}
+
+TEST("create from temporary") {
+    URI src("myscheme3://ya.ru/path?a=b");
+    src.query();
+    auto* node = &*src.query().cbegin();
+    auto uri = URI::create(std::move(src));
+    CHECK_TYPE(uri, MyScheme3);
+    CHECK(&*uri->query().cbegin() == node);
+    CHECK(src.empty());
+
+    URI old("myscheme2://ya.ru"); // registered without mover, falls back to copy
+    uri = URI::create(std::move(old));
+    CHECK_TYPE(uri, MyScheme2);
+    CHECK(uri->host() == "ya.ru");
+}
+
+TEST("null type") {
+    auto uri = URI::create("notype://ya.ru");
+    CHECK_TYPE(uri, URI);
+    CHECK(uri->port() == 9999);
+    CHECK(URI::type_id<Unregistered>() == -1);
+    CHECK_THROWS_AS(Unregistered("notype://ya.ru"), WrongScheme);
+    CHECK(!URI::try_register_scheme("notype", nullptr, nullptr, nullptr, 1));
+}
+
+TEST("try register") {
+    CHECK(!URI::try_register_scheme<MyScheme3>("myscheme3", 1));
+    CHECK(!URI::try_register_scheme<URI>("http", 1));
+    CHECK(URI::create("myscheme3://a")->port() == 8888);
+    CHECK_THROWS_AS(URI::register_scheme("http", 1), std::invalid_argument);
+}
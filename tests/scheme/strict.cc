@@ -53,3 +53,188 @@ TEST("apply strict scheme to proto-relative urls") {
         CHECK(uri.to_string() == "ftp://syber.ru/abc");
     }
 }
+
+TEST("suffix reference with port") {
+    const int flags = URI::Flags::allow_suffix_reference;
+
+    URI::http uri("ya.ru:80/a/b", flags);
+    CHECK(uri.scheme() == "http");
+    CHECK(uri.host() == "ya.ru");
+    CHECK(uri.port() == 80);
+    CHECK(uri.path() == "/a/b");
+
+    uri.assign("localhost:8080", flags);
+    CHECK(uri.host() == "localhost");
+    CHECK(uri.port() == 8080);
+
+    uri = URI::http("example.com:443/x?y=1", flags);
+    CHECK(uri.host() == "example.com");
+    CHECK(uri.param("y") == "1");
+
+    ParseError err;
+    CHECK(uri.try_assign("localhost:8080/p", err, flags));
+    CHECK(!err);
+    CHECK(uri.to_string() == "http://localhost:8080/p");
+
+    auto parsed = URI::https::try_parse("example.com:443/x", err, flags);
+    CHECK(!err);
+    CHECK(parsed.to_string() == "https://example.com:443/x");
+
+    // real scheme is still checked, after the guess
+    CHECK_THROWS_AS(URI::http("ftp://ya.ru/a", flags), WrongScheme);
+    uri = URI::http::try_parse("ftp://ya.ru/a", err, flags);
+    CHECK(err.kind == ParseError::wrong_scheme);
+    CHECK(uri.empty());
+}
+
+TEST("move") {
+    URI src("http://a.b/path?x=1");
+    URI::http uri(std::move(src));
+    CHECK(uri.to_string() == "http://a.b/path?x=1");
+    CHECK(src.empty());
+
+    URI::http moved(std::move(uri));
+    CHECK(moved.host() == "a.b");
+
+    URI wrong("ftp://a.b");
+    CHECK_THROWS_AS(URI::http(std::move(wrong)), WrongScheme);
+
+    URI::ftp ftp("ftp://a.b");
+    CHECK_THROWS_AS(moved = std::move(ftp), WrongScheme);
+
+    URISP sp = URI::create("https://c.d");
+    *sp = URI("https://e.f");
+    CHECK(sp->host() == "e.f");
+}
+
+TEST("final types") {
+    static_assert(std::is_final<URI::http>::value && std::is_final<URI::wss>::value && std::is_final<URI::telnet>::value, "");
+
+    URI::http uri("http://a.b");
+    uri = "https://c.d/e";
+    CHECK(uri.host() == "c.d");
+    CHECK(uri.scheme() == "https");
+    uri.assign("//f.g", URI::Flags::query_param_semicolon);
+    CHECK(uri.scheme() == "http");
+    CHECK_THROWS_AS(uri = "ftp://a.b", WrongScheme);
+    CHECK_THROWS_AS(uri.assign("ws://a.b"), WrongScheme);
+
+    URI::http copy("http://x.y");
+    CHECK_THROWS_AS(copy = uri, WrongScheme); // uri is left with rejected scheme
+    uri = URI::https("https://h.i");
+    CHECK(uri.host() == "h.i");
+    CHECK_THROWS_AS(uri = URI("wss://a.b"), WrongScheme);
+}
+
+TEST("type ids") {
+    CHECK(URI::type_id<URI::http>() >= 0);
+    CHECK(URI::type_id<URI::http>() == URI::type_id(typeid(URI::http)));
+    CHECK(URI::type_id<URI::http>() != URI::type_id<URI::https>());
+    CHECK(URI::type_id<URI::ssh>()  != URI::type_id<URI::sftp>());
+    CHECK(URI::type_id<URIStrict>() == -1);
+
+    URI::http uri("https://a.b"); // friend type is accepted
+    CHECK(uri.scheme() == "https");
+    CHECK_THROWS_AS(URI::sftp("ssh://a.b"), WrongScheme); // same default port, different type
+}
+
+TEST("early scheme rejection") {
+    URI::http uri("http://a.b/c");
+    CHECK_THROWS_AS(uri = "ftp://a.b/very/long/path?q=1", WrongScheme);
+    CHECK(uri.scheme() == "ftp"); // only the scheme has been parsed
+    CHECK(uri.host() == "");
+    CHECK(uri.path() == "");
+
+    // input is rejected by scheme before the parser reaches invalid part
+    CHECK_THROWS_AS(URI::http("ftp://a.b/inva lid"), WrongScheme);
+    CHECK_THROWS_AS(URI::http("FTP://a.b"), WrongScheme);
+    CHECK_THROWS_AS(URI::http("unknown://a.b"), WrongScheme);
+    CHECK(URI::http("HTTPS://a.b").scheme() == "https");
+    CHECK_THROWS_AS(URI::https("http://a.b", URI::Flags::allow_extended_chars), WrongScheme);
+}
+
+TEST("malformed input") {
+    // scheme is checked first: malformed input with a wrong scheme throws, while with a fitting one URI is left empty
+    CHECK_THROWS_AS(URI::http("ftp://a b/c"), WrongScheme);
+    URI::http uri("http://a b/c");
+    CHECK(uri.empty());
+
+    ParseError err;
+    URI::http::try_parse("ftp://a b/c", err);
+    CHECK(err.kind == ParseError::wrong_scheme);
+    URI::http::try_parse("http://a b/c", err);
+    CHECK(err.kind == ParseError::syntax);
+}
+
+TEST("try_assign") {
+    URI::http uri;
+    CHECK(uri.try_assign("https://a.b/c?d=e"));
+    CHECK(uri.host() == "a.b");
+    CHECK(uri.param("d") == "e");
+
+    CHECK(!uri.try_assign("ftp://a.b/c"));
+    CHECK(uri.empty());
+    CHECK(uri.scheme() == "");
+
+    CHECK(uri.try_assign("//a.b"));
+    CHECK(uri.scheme() == "http");
+
+    CHECK(!uri.try_assign("http://a.b#c#d")); // invalid input fails too
+    CHECK(uri.empty());
+
+    URI::ftp ftp;
+    CHECK(!ftp.try_assign("sftp://a.b"));
+    CHECK(ftp.try_assign("Ftp://a.b", URI::Flags::allow_extended_chars));
+    CHECK(ftp.scheme() == "ftp");
+}
+
+TEST("try_assign via base reference") {
+    URI::http h("http://a.b");
+    URI& u = h;
+    ParseError err;
+    CHECK(!u.try_assign("ftp://x.y/z", err));
+    CHECK(err.kind == ParseError::wrong_scheme);
+    CHECK(h.scheme() != "ftp");
+    CHECK(h.empty());
+
+    CHECK(!u.try_assign("ftp://x.y/z"));
+    CHECK(u.try_assign("https://x.y/z", err));
+    CHECK(h.scheme() == "https");
+}
+
+TEST("try_parse") {
+    ParseError err;
+    auto uri = URI::http::try_parse("https://a.b/c", err);
+    static_assert(std::is_same<decltype(uri), URI::http>::value, "");
+    CHECK(!err);
+    CHECK(uri.scheme() == "https");
+
+    uri = URI::http::try_parse("ftp://a.b/c", err);
+    CHECK(err.kind == ParseError::wrong_scheme);
+    CHECK(err.position == 3);
+    CHECK(uri.empty());
+
+    uri = URI::http::try_parse("http://a.b/c d", err);
+    CHECK(err.kind == ParseError::syntax);
+    CHECK(err.position == 12);
+
+    CHECK(uri.try_assign("//a.b", err));
+    CHECK(!err);
+    CHECK(uri.scheme() == "http");
+}
+
+TEST("try_create") {
+    ParseError err;
+    auto uri = URI::try_create("wss://a.b/c", err);
+    CHECK(!err);
+    CHECK_TYPE(uri, URI::wss);
+
+    uri = URI::try_create("unknown://a.b", err);
+    CHECK(!err);
+    CHECK_TYPE(uri, URI);
+
+    uri = URI::try_create("wss://a.b/c d", err);
+    CHECK(!uri);
+    CHECK(err.kind == ParseError::syntax);
+    CHECK(err.position == 11);
+}
@@ -0,0 +1,91 @@
+#include "test.h"
+#include <atomic>
+#include <thread>
+
+#define TEST(name) TEST_CASE("stats: " name, "[stats]")
+
+using stats::Counter;
+using stats::Histogram;
+
+TEST("bucket") {
+    CHECK(stats::bucket(0) == 0);
+    CHECK(stats::bucket(1) == 1);
+    CHECK(stats::bucket(2) == 2);
+    CHECK(stats::bucket(3) == 2);
+    CHECK(stats::bucket(4) == 3);
+    CHECK(stats::bucket(1023) == 10);
+    CHECK(stats::bucket(1024) == 11);
+    CHECK(stats::bucket(uint64_t(-1)) == 64);
+}
+
+TEST("to_string") {
+    stats::Snapshot s;
+    s.counters[size_t(Counter::parse)] = 10;
+    s.histograms[size_t(Histogram::uri_length)][0] = 1;
+    s.histograms[size_t(Histogram::uri_length)][6] = 7;
+    s.histograms[size_t(Histogram::query_params)][64] = 2;
+    auto str = s.to_string();
+    CHECK(str.find("parse 10\n") == 0);
+    CHECK(str.find("parse_failed 0\n") != string::npos);
+    CHECK(str.find("uri_length [0, 1) 1\n") != string::npos);
+    CHECK(str.find("uri_length [32, 64) 7\n") != string::npos);
+    CHECK(str.find("query_params [9223372036854775808, inf) 2\n") != string::npos);
+    CHECK(str.find("query_length") == string::npos);
+}
+
+TEST("events") {
+    stats::reset();
+    URI uri("http://example.com/path?a=1&b=2");
+    URI bad("http://exa mple.com");
+    URI upper("FTP://example.com");
+    uri.param("a");
+    uri.param("c", "3");
+    uri.query_string();
+
+    auto s = stats::snapshot();
+    if (!stats::enabled) {
+        CHECK(s.to_string().find("parse 0\n") == 0);
+        return;
+    }
+
+    CHECK(s[Counter::parse] == 3);
+    CHECK(s[Counter::parse_failed] == 1);
+    CHECK(s[Counter::parse_query] == 1);
+    CHECK(s[Counter::compile_query] == 1);
+    CHECK(s[Counter::scheme_detach] == 1);
+    CHECK(s[Histogram::uri_length][stats::bucket(31)] == 3); // all three are in [16, 32)
+    CHECK(s[Histogram::query_params][stats::bucket(2)] == 1);
+    CHECK(s[Histogram::query_length][stats::bucket(7)] == 1);
+
+    std::thread([]{ URI("http://example.com"); }).join();
+    CHECK(stats::snapshot()[Counter::parse] == 4);
+
+    stats::reset();
+    CHECK(stats::snapshot()[Counter::parse] == 0);
+}
+
+TEST("reset while other threads parse") {
+    if (!stats::enabled) return;
+    std::atomic<uint64_t> done(0);
+    std::atomic<bool>     stop(false);
+    string src = "http://example.com/path";
+    std::thread worker([&]{
+        string local(src.data(), src.length());
+        while (!stop) {
+            URI uri(local);
+            ++done;
+        }
+    });
+
+    // a reset must not be undone by an increment in flight, so that after it only later parses are counted
+    int overcounted = 0;
+    for (int i = 0; i < 1000; ++i) {
+        auto before = done.load();
+        stats::reset();
+        auto parsed = stats::snapshot()[Counter::parse];
+        if (parsed > done.load() - before + 1) ++overcounted; // +1 for a parse counted but not yet added to 'done'
+    }
+    CHECK(overcounted == 0);
+    stop = true;
+    worker.join();
+}